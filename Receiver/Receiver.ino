@@ -2,102 +2,338 @@
 #include <nRF24L01.h>
 #include <RF24.h>
 #include <Servo.h>  // To create PWM signals we need this library
+#include <EEPROM.h>
+#include <util/crc16.h>
+#include <RCLink.h>
+#include <RCFrame.h>
+#include <RCTiming.h>
+#include <RCProfiler.h>
+#include <RCLatency.h>
 
 const uint64_t pipeIn = 0xE8E8F0F0E1LL;     // Remember that this code is the same as in the transmitter
 RF24 radio(9, 10);  // CSN and CE pins
 
-// The size of this struct should not exceed 32 bytes
-struct Received_data {
-  byte ch1;
-  byte ch2;
-  byte ch3;
-  byte ch4;
-  byte ch5;
-  byte ch6;
-  byte ch7;
-  byte ch8;
-  byte ch9;
-  byte ch10;
+// Receiver configuration (ReceiverConfig in RCLink.h): the model slot to follow, the servo
+// output pin of each channel, the failsafe values and the pulse range. It is set over the
+// air by the transmitter (tools/rx_config.py) and kept in EEPROM as a CRC-16 followed by
+// the config; without a valid one these defaults apply.
+const int CONFIG_ADDRESS = 0;
+const ReceiverConfig defaultConfig = {
+  RC_RECEIVER_CONFIG_VERSION,
+  0,                                                 // Model slot
+  {2, 3, 4, 5, 6, 7, 8, A3, A4, A5},                 // Output pins
+  {0, 127, 127, 127, 127, 0, 0, 0, 0, 0},            // Failsafe: sticks centered, the rest at 0
+  1000, 2000,                                        // Pulse range
+  1000                                               // Failsafe after 1 second without signal
 };
 
-Received_data received_data;
-
-Servo channel_1;
-Servo channel_2;
-Servo channel_3;
-Servo channel_4;
-Servo channel_5;
-Servo channel_6;
-Servo channel_7;
-Servo channel_8;
-Servo channel_9;
-Servo channel_10;
-
-int ch1_value = 0;
-int ch2_value = 0;
-int ch3_value = 0;
-int ch4_value = 0;
-int ch5_value = 0;
-int ch6_value = 0;
-int ch7_value = 0;
-int ch8_value = 0;
-int ch9_value = 0;
-int ch10_value = 0;
+static_assert(RC_CHANNEL_COUNT <= 12, "The Servo library drives at most 12 outputs on the ATmega328P");
+
+ReceiverConfig config;
+ReceiverConfig stagedConfig;                 // Collected from config messages until a commit
+ReceiverStatus configStatus = {0, RC_CONFIG_NONE, 0};   // Sent back as ack payload
+uint8_t configImage[sizeof(uint16_t) + sizeof(ReceiverConfig)];   // CRC and config being saved
+uint8_t configSaved = sizeof(configImage);   // Bytes of configImage in EEPROM
+
+ChannelValues received_data;  // Full channel state, rebuilt from the frames
+FrameDecoder decoder;
+
+Servo servos[RC_CHANNEL_COUNT];
+
+#ifdef RC_PROFILE
+// Profiled stages (RCProfiler.h), the report is sent for a 'P' on the serial port
+enum ProfileStage : uint8_t {
+  PROFILE_RECEIVE,   // Draining the radio FIFO
+  PROFILE_OUTPUTS,   // Writing every servo pulse width
+  PROFILE_LOOP,      // Whole loop()
+  PROFILE_STAGES
+};
+
+const char profileReceive[] PROGMEM = "receive";
+const char profileOutputs[] PROGMEM = "outputs";
+const char profileLoop[] PROGMEM = "loop";
+const char* const profileNames[PROFILE_STAGES] PROGMEM = {profileReceive, profileOutputs, profileLoop};
+const uint16_t profileBudgets[PROFILE_STAGES] PROGMEM = {500, 500, 1000};
+
+ProfileStats profileStats[PROFILE_STAGES];
+Profiler profiler(profileStats, PROFILE_STAGES, profileNames, profileBudgets);
+#endif
 
 void reset_the_Data() 
 {
   // 'Safe' values to use when NO radio input is detected
-  received_data.ch1 = 0;      // Throttle (channel 1) to 0
-  received_data.ch2 = 127;
-  received_data.ch3 = 127;
-  received_data.ch4 = 127;
-  received_data.ch5 = 127;
-  received_data.ch6 = 0;
-  received_data.ch7 = 0;
-  received_data.ch8 = 0;
-  received_data.ch9 = 0;
-  received_data.ch10 = 0;
+  decoder.reset();  // Deltas must wait for a fresh keyframe
+  memcpy(received_data.values, config.failsafe, RC_CHANNEL_COUNT);
+}
+
+/**************************************************/
+
+uint16_t config_crc(const ReceiverConfig& c)
+{
+  uint16_t crc = 0xFFFF;
+  for (uint8_t i = 0; i < sizeof(c); i++) {
+    crc = _crc16_update(crc, ((const uint8_t*)&c)[i]);
+  }
+  return crc;
+}
+
+// Pins 0-1 are the serial port, 9-13 the radio's CE, CSN and SPI
+bool config_is_valid(const ReceiverConfig& c)
+{
+  if (c.version != RC_RECEIVER_CONFIG_VERSION) return false;
+  if (c.pulseMinMicros < MIN_PULSE_WIDTH || c.pulseMaxMicros > MAX_PULSE_WIDTH ||
+      c.pulseMinMicros >= c.pulseMaxMicros) return false;
+  if (c.failsafeMillis < 100) return false;  // A few lost frames must not trigger it
+  for (uint8_t i = 0; i < RC_CHANNEL_COUNT; i++) {
+    uint8_t pin = c.servoPins[i];
+    if (pin == RC_NO_OUTPUT) continue;
+    if (pin < 2 || (pin >= 9 && pin <= 13) || pin > A5) return false;
+    for (uint8_t j = 0; j < i; j++) {
+      if (c.servoPins[j] == pin) return false;
+    }
+  }
+  return true;
+}
+
+// Switch to a validated config, moving only the outputs whose pin changed
+void apply_config(const ReceiverConfig& next)
+{
+#ifndef SIM_TIMING  // The timing build counts cycles with Timer1, which Servo would take over
+  for (uint8_t i = 0; i < RC_CHANNEL_COUNT; i++) {
+    if (servos[i].attached() && next.servoPins[i] == config.servoPins[i]) continue;
+    servos[i].detach();
+    if (next.servoPins[i] != RC_NO_OUTPUT) servos[i].attach(next.servoPins[i]);
+  }
+#endif
+  config = next;
+  configStatus.configCrc = config_crc(config);
+}
+
+void load_config()
+{
+  uint16_t storedCrc;
+  ReceiverConfig stored;
+  EEPROM.get(CONFIG_ADDRESS, storedCrc);
+  EEPROM.get(CONFIG_ADDRESS + sizeof(storedCrc), stored);
+  bool valid = storedCrc == config_crc(stored) && config_is_valid(stored);
+  apply_config(valid ? stored : defaultConfig);
+}
+
+// Write the next byte of the config being saved once the EEPROM is idle: a byte takes
+// 3.3 ms, writing all of them at once would stall the servo updates
+void save_the_config()
+{
+  if (configSaved == sizeof(configImage) || !eeprom_is_ready()) return;
+  EEPROM.update(CONFIG_ADDRESS + configSaved, configImage[configSaved]);
+  configSaved++;
+}
+
+// Handle a config message from the transmitter (RCLink.h) and load the status its next
+// message's ack will carry. Repeated messages (a lost ack) are harmless: chunks are
+// written again and a commit applies the same config.
+void handle_config_message(const RadioFrame& frame, uint8_t length)
+{
+  if (length < RC_FRAME_HEADER_SIZE + 2 || length > RC_FRAME_SIZE) return;
+  uint8_t operation = frame.data[1];
+  uint8_t size = length - RC_FRAME_HEADER_SIZE - 2;
+  const uint8_t* payload = frame.data + 2;
+
+  if (operation == RC_CONFIG_COMMIT) {
+    uint16_t crc;
+    if (size != sizeof(crc)) return;
+    memcpy(&crc, payload, sizeof(crc));
+    if (crc == config_crc(stagedConfig) && config_is_valid(stagedConfig)) {
+      apply_config(stagedConfig);
+      memcpy(configImage, &configStatus.configCrc, sizeof(uint16_t));
+      memcpy(configImage + sizeof(uint16_t), &config, sizeof(config));
+      configSaved = 0;
+      configStatus.result = RC_CONFIG_APPLIED;
+    } else {
+      configStatus.result = RC_CONFIG_REJECTED;
+    }
+  } else if (operation != RC_CONFIG_STATUS) {
+    if (operation + size > sizeof(stagedConfig)) return;
+    memcpy((uint8_t*)&stagedConfig + operation, payload, size);
+    configStatus.result = RC_CONFIG_STORED;
+  }
+  configStatus.sequence = frame.data[0];
+
+  radio.flush_tx();  // Only the latest status
+  radio.writeAckPayload(1, &configStatus, sizeof(configStatus));
 }
 
 /**************************************************/
 
 void setup()
 {
-  // Attach the servo signal on pins from D2 to D11
-  channel_1.attach(2);
-  channel_2.attach(3);
-  channel_3.attach(4);
-  channel_4.attach(5);
-  channel_5.attach(6);
-  channel_6.attach(7);
-  channel_7.attach(8);
-  channel_8.attach(A3);
-  channel_9.attach(A4);
-  channel_10.attach(A5);
+  // Attach the servo signal on the configured output pins
+  load_config();
   
   // Reset the received values
   reset_the_Data();
 
   // Begin radio communication and configuration
   radio.begin();
-  radio.setAutoAck(false);
   radio.setDataRate(RF24_250KBPS);  
+  radio.enableDynamicPayloads();  // Same as the transmitter, frames vary in length
+  radio.enableDynamicAck();
+  radio.enableAckPayload();       // Config messages are answered with configStatus
   radio.openReadingPipe(1, pipeIn);
+  radio.writeAckPayload(1, &configStatus, sizeof(configStatus));
   
   // Start listening for incoming radio signals
   radio.startListening();
+
+#if defined(RC_PROFILE) || defined(RC_TRACE) || defined(RC_LATENCY)
+  Serial.begin(115200);
+#endif
+
+#ifdef RC_LATENCY
+  // Pin changes on port D, arm_latency_measurement picks the pin
+  PCICR |= _BV(PCIE2);
+#endif
+
+#ifdef SIM_TIMING
+  runTimingScript();
+#endif
 }
 
 /**************************************************/
 
 unsigned long lastRecvTime = 0;
 
+#ifdef RC_LATENCY
+// Stick-to-servo latency of channel 1: the transmitter's sample age, the frame's airtime and
+// the time from receiving the frame to the rising edge of the first pulse that carries it.
+// Only the last frame written before an edge reaches the servo, earlier ones are
+// superseded and not counted. Percentiles are printed every few seconds. Channel 1's
+// output pin comes from the config and must be on port D (pins 2-7, PCINT18-23).
+const unsigned long LATENCY_REPORT_MS = 5000;
+
+LatencyStats latencyStats(500);
+uint16_t frameInputAge;                           // Sample age + airtime of the frame last received
+unsigned long frameRecvMicros;
+volatile bool latencyArmed = false;               // Written to the servo, waiting for its edge
+volatile uint16_t armedInputAge;
+volatile unsigned long armedRecvMicros;
+volatile bool latencyReady = false;
+volatile uint32_t latencyResult;
+volatile uint8_t latencyPinMask = 0;              // Port D bit of channel 1's output, 0 if not there
+unsigned long lastLatencyReport = 0;
+
+ISR(PCINT2_vect)
+{
+  if (!(PIND & latencyPinMask) || !latencyArmed) return;
+  latencyResult = armedInputAge + (micros() - armedRecvMicros);
+  latencyArmed = false;
+  latencyReady = true;
+}
+
+// The frame just written to the servos is the one the next pulse will carry
+void arm_latency_measurement()
+{
+  // The config can move the output at any time
+  uint8_t pin = config.servoPins[0];
+  uint8_t mask = (pin >= 2 && pin <= 7) ? _BV(pin) : 0;
+  if (mask != latencyPinMask) {
+    noInterrupts();
+    latencyPinMask = mask;
+    PCMSK2 = mask;
+    latencyArmed = false;
+    interrupts();
+  }
+  if (frameRecvMicros == 0 || mask == 0) return;
+  noInterrupts();
+  armedInputAge = frameInputAge;
+  armedRecvMicros = frameRecvMicros;
+  latencyArmed = true;
+  interrupts();
+  frameRecvMicros = 0;
+}
+
+void report_latency()
+{
+  if (latencyReady) {
+    noInterrupts();
+    uint32_t latency = latencyResult;
+    latencyReady = false;
+    interrupts();
+    latencyStats.add(latency);
+  }
+  if (millis() - lastLatencyReport >= LATENCY_REPORT_MS) {
+    lastLatencyReport = millis();
+    if (latencyPinMask == 0) {
+      Serial.println(F("latency: channel 1 output is not on pins 2-7"));
+      return;
+    }
+    latencyStats.report(Serial, F("latency"));
+  }
+}
+#endif
+
+#ifdef RC_TRACE
+// Radio trace for tools/trace.py: the channel state rebuilt from every frame of this
+// model as an 'R' record, in the transmitter's trace format (sync 0xA5, type, uint16
+// microseconds since the previous record, then the ChannelValues)
+unsigned long lastTraceMicros = 0;
+
+void trace_the_frame(const ChannelValues& state)
+{
+  unsigned long now = micros();
+  uint16_t elapsed = min(now - lastTraceMicros, 0xFFFFUL);
+  lastTraceMicros = now;
+  Serial.write((uint8_t)0xA5);
+  Serial.write((uint8_t)'R');
+  Serial.write((const uint8_t*)&elapsed, sizeof(elapsed));
+  Serial.write((const uint8_t*)&state, sizeof(state));
+}
+#endif
+
 // We create the function that will read the data each certain time
 void receive_the_data()
 {
+  PROFILE_SCOPE(PROFILE_RECEIVE);
+
+#ifdef SIM_TIMING
+  // No nRF24 in the emulator: a centered frame arrives on every call
+  received_data.modelId = config.modelId;
+  memset(received_data.values, 127, sizeof(received_data.values));
+  lastRecvTime = millis();
+  return;
+#endif
+
   while (radio.available()) {
-    radio.read(&received_data, sizeof(Received_data));
+    RadioFrame frame;
+    uint8_t length = radio.getDynamicPayloadSize();
+    radio.read(&frame, min(length, sizeof(frame)));
+    if (frame.modelId != config.modelId) {
+      continue;  // Another model is selected on the transmitter, don't follow its sticks
+    }
+    if (frame.layout & RC_FRAME_CONFIG) {
+      handle_config_message(frame, length);
+      continue;
+    }
+    if (!decoder.decode(frame, length, received_data)) {
+      continue;  // Malformed, or a delta whose keyframe was lost
+    }
     lastRecvTime = millis(); // Here we receive the data
+#ifdef RC_TRACE
+    trace_the_frame(received_data);
+#endif
+#ifdef RC_LATENCY
+    frameInputAge = ((frame.layout & RC_FRAME_TIMED) ? readSampleAge(frame, length) : 0) + rcFrameAirtime(length);
+    frameRecvMicros = micros();
+#endif
+  }
+}
+
+// Map the received data to the configured pulse range and create the PWM signals
+void write_the_outputs()
+{
+  PROFILE_SCOPE(PROFILE_OUTPUTS);
+  for (uint8_t i = 0; i < RC_CHANNEL_COUNT; i++) {
+    if (config.servoPins[i] == RC_NO_OUTPUT) continue;
+    servos[i].writeMicroseconds(map(received_data.values[i], 0, 255, config.pulseMinMicros, config.pulseMaxMicros));
   }
 }
 
@@ -105,12 +341,17 @@ void receive_the_data()
 
 void loop()
 {
+#ifdef RC_PROFILE
+  serviceProfileRequest(Serial);
+#endif
+  PROFILE_SCOPE(PROFILE_LOOP);
+
   // Receive the radio data
   receive_the_data();
 
-  // Reset data if signal is lost for 1 second
+  // Reset data if signal is lost for the configured time (1 second by default)
   unsigned long now = millis();
-  if (now - lastRecvTime > 1000) {
+  if (now - lastRecvTime > config.failsafeMillis) {
     // Signal lost?
     reset_the_Data();
     // Go up and change the initial values if you want depending on
@@ -118,28 +359,26 @@ void loop()
     // fly away
   } 
 
-  // Map the received data to PWM range (1000-2000 microseconds)
-  ch1_value = map(received_data.ch1, 0, 255, 1000, 2000);
-  ch2_value = map(received_data.ch2, 0, 255, 1000, 2000);
-  ch3_value = map(received_data.ch3, 0, 255, 1000, 2000);
-  ch4_value = map(received_data.ch4, 0, 255, 1000, 2000);
-  ch5_value = map(received_data.ch5, 0, 255, 1000, 2000);
-  ch6_value = map(received_data.ch6, 0, 255, 1000, 2000);
-  ch7_value = map(received_data.ch7, 0, 255, 1000, 2000);
-  ch8_value = map(received_data.ch8, 0, 255, 1000, 2000);
-  ch9_value = map(received_data.ch9, 0, 255, 1000, 2000);
-  ch10_value = map(received_data.ch10, 0, 255, 1000, 2000);
-
-  // Create the PWM signals
-  channel_1.writeMicroseconds(ch1_value);  
-  channel_2.writeMicroseconds(ch2_value);  
-  channel_3.writeMicroseconds(ch3_value);  
-  channel_4.writeMicroseconds(ch4_value);  
-  channel_5.writeMicroseconds(ch5_value);  
-  channel_6.writeMicroseconds(ch6_value);  
-  channel_7.writeMicroseconds(ch7_value);  
-  channel_8.writeMicroseconds(ch8_value);  
-  channel_9.writeMicroseconds(ch9_value);  
-  channel_10.writeMicroseconds(ch10_value);  
-  
+  write_the_outputs();
+  save_the_config();
+#ifdef RC_LATENCY
+  arm_latency_measurement();
+  report_latency();
+#endif
+
 } // Loop end
+
+#ifdef SIM_TIMING
+// Timing script for the emulator build (tools/avr_timing.py): worst loop() and output
+// update in cycles
+void runTimingScript()
+{
+  Serial.begin(9600);
+  startCycleCounter();
+
+  reportTiming(F("loop"), worstCycles([] { loop(); }));
+  reportTiming(F("outputs"), worstCycles([] { write_the_outputs(); }));
+  reportTiming(F("unusedStack"), unusedStack());
+  reportTiming(F("done"), 0);
+}
+#endif
@@ -2,6 +2,9 @@
 #define CHANNEL_H
 
 #include <Arduino.h>
+#include "InputTrace.h"
+#include "DigitalInputs.h"
+#include "InputBackends.h"
 
 // Enum to define types of input
 enum InputType {
@@ -10,6 +13,40 @@ enum InputType {
     THREE_STATE      // 3-state switch input
 };
 
+// Same conversion as analogRead (AVcc reference, prescaler set up by the core), with the
+// ADC channel resolved at compile time
+template<uint8_t PIN>
+inline uint16_t fastAnalogRead() {
+    static_assert(PIN >= A0 && PIN <= A7, "Pin has no analog input");
+#ifdef RC_TRACE
+    if (inputTrace.replaying()) return inputTrace.sample.analog[PIN - A0];
+#endif
+    ADMUX = _BV(REFS0) | (PIN - A0);
+    ADCSRA |= _BV(ADSC);
+    while (ADCSRA & _BV(ADSC));
+#ifdef RC_TRACE
+    inputTrace.sample.analog[PIN - A0] = ADC;
+#endif
+    return ADC;
+}
+
+// analogRead for the generic reader, traced like fastAnalogRead
+inline uint16_t channelAnalogRead(uint8_t pin) {
+#ifdef RC_TRACE
+    uint8_t index = pin - A0;
+    if (index < TRACE_ANALOG_PINS) {
+        if (inputTrace.replaying()) return inputTrace.sample.analog[index];
+        return inputTrace.sample.analog[index] = analogRead(pin);
+    }
+#endif
+    return analogRead(pin);
+}
+
+class Channel;
+
+// A channel's reader, chosen once per channel when channels are loaded
+typedef int (Channel::*ChannelReader)();
+
 class Channel {
 private:
     int pin;               // Pin number (single pin for analog and digital, two pins for 3-state switch)
@@ -22,17 +59,24 @@ private:
     int minEndpoint;       // Minimum endpoint
     int maxEndpoint;       // Maximum endpoint
     int centerPoint;       // Center point adjustment
+    ChannelReader reader;  // Type and pin specific reader used by read()
+    InputBackend* backend; // External input source, nullptr for on-chip pins
+    uint8_t source;        // Input index on the backend
 
 public:
     Channel()
         : pin(-1), pin2(-1), inputType(ANALOG), reverse(false), trim(0), analogReadMin(0), analogReadMax(1023),
-          minEndpoint(0), maxEndpoint(255), centerPoint(127) {}
+          minEndpoint(0), maxEndpoint(255), centerPoint(127), reader(&Channel::readAnalog),
+          backend(nullptr), source(0) {}
 
     // Setter for pin with mode handling
     void setPin(int p) {
         pin = p;
+        backend = nullptr;
         // Set the pin mode based on input type
-        if (inputType == ANALOG) {
+        if (pin < 0) {
+            return;  // No pin (backend channel)
+        } else if (inputType == ANALOG) {
             pinMode(pin, INPUT);  // Analog inputs are set to INPUT
         } else if (inputType == DIGITAL || inputType == THREE_STATE) {
             pinMode(pin, INPUT_PULLUP);  // Digital or 3-state inputs are set to INPUT_PULLUP
@@ -43,6 +87,7 @@ public:
     void setPin(int p, int p2) {
         pin = p;
         pin2 = p2;
+        backend = nullptr;
         // Set the pin mode based on input type
         if (inputType == ANALOG) {
             pinMode(pin, INPUT);  // Analog inputs are set to INPUT
@@ -52,6 +97,17 @@ public:
         }
     }
 
+    // Source the channel from an external backend input instead of a pin. The channel
+    // gives up its pins: they may be the backend's bus pins, which a later setInputType()
+    // must not touch.
+    void setBackend(InputBackend* b, uint8_t s) {
+        pin = -1;
+        pin2 = -1;
+        backend = b;
+        source = s;
+        backend->begin();
+    }
+
     // Getter for pin
     int getPin() const {
         return pin;
@@ -61,11 +117,13 @@ public:
     void setInputType(InputType type) {
         inputType = type;
         // Set the pin mode based on the new input type
-        if (inputType == ANALOG) {
+        if (pin < 0) {
+            return;  // No pin (backend channel)
+        } else if (inputType == ANALOG) {
             pinMode(pin, INPUT);  // Analog inputs are set to INPUT
         } else if (inputType == DIGITAL || inputType == THREE_STATE) {
             pinMode(pin, INPUT_PULLUP);  // Digital or 3-state inputs are set to INPUT_PULLUP
-            pinMode(pin2, INPUT_PULLUP);  // Digital or 3-state inputs are set to INPUT_PULLUP
+            if (pin2 >= 0) pinMode(pin2, INPUT_PULLUP);  // Digital or 3-state inputs are set to INPUT_PULLUP
         }
     }
 
@@ -74,6 +132,20 @@ public:
         return inputType;
     }
 
+    // Use a pin-specialized reader (see predefinedReaders)
+    void setReader(ChannelReader r) {
+        reader = r;
+    }
+
+    // Use the generic reader for the current input type and pins
+    void setGenericReader() {
+        switch (inputType) {
+            case DIGITAL:     reader = &Channel::readDigital; break;
+            case THREE_STATE: reader = &Channel::readSwitch; break;
+            default:          reader = &Channel::readAnalog; break;
+        }
+    }
+
     void getReverse() {
         return reverse;
     }
@@ -108,30 +180,12 @@ public:
     }
 
     uint16_t getAnalogValue() {
+        if (backend) return backend->read(source);
         return ::analogRead(pin);
     }
 
     int read() {
-        int value = 0;
-        switch (inputType) {
-            case ANALOG:
-                value = analogRead(pin);
-                value = map(value, analogReadMin, analogReadMax, minEndpoint, maxEndpoint);
-                break;
-
-            case DIGITAL:
-                value = digitalRead(pin);
-                value = map(value, LOW, HIGH, minEndpoint, maxEndpoint);
-                break;
-
-            case THREE_STATE:
-                value = readSwitch();  // Read from two digital pins for 3-state switch
-                break;
-
-            default:
-                value = 0;
-                break;
-        }
+        int value = (this->*reader)();
 
         if (reverse) {
             value = 255 - value;
@@ -141,10 +195,22 @@ public:
         return value;
     }
 
+    // Generic readers, resolving the pin at runtime
+
+    int readAnalog() {
+        return map(channelAnalogRead(pin), analogReadMin, analogReadMax, minEndpoint, maxEndpoint);
+    }
+
+    // Digital pins decode from this frame's port snapshot (digitalInputs)
+
+    int readDigital() {
+        return digitalInputs.read(pin) ? maxEndpoint : minEndpoint;
+    }
+
     int readSwitch() {
         // Read the two pins for the 3-state switch
-        int state1 = digitalRead(pin);
-        int state2 = digitalRead(pin2);
+        int state1 = digitalInputs.read(pin);
+        int state2 = digitalInputs.read(pin2);
         
         if (state1 == LOW && state2 == LOW) {
             return centerPoint;  // State 2: LOW, HIGH
@@ -156,6 +222,41 @@ public:
             return centerPoint;  // Default to center if both HIGH (optional)
         }
     }
+
+    // Backend readers, the value was fetched between frames
+
+    int readBackendAnalog() {
+        return map(backend->read(source), analogReadMin, analogReadMax, minEndpoint, maxEndpoint);
+    }
+
+    int readBackendDigital() {
+        return backend->read(source) ? maxEndpoint : minEndpoint;
+    }
+
+    // Readers specialized per pin at compile time
+
+    template<uint8_t PIN>
+    int readAnalogPin() {
+        return map(fastAnalogRead<PIN>(), analogReadMin, analogReadMax, minEndpoint, maxEndpoint);
+    }
+
+    template<uint8_t PIN>
+    int readDigitalPin() {
+        return digitalInputs.read<PIN>() ? maxEndpoint : minEndpoint;
+    }
+
+    template<uint8_t PIN1, uint8_t PIN2>
+    int readSwitchPins() {
+        bool state1 = digitalInputs.read<PIN1>();
+        bool state2 = digitalInputs.read<PIN2>();
+
+        if (!state1 && state2) {
+            return minEndpoint;  // State 1
+        } else if (state1 && !state2) {
+            return maxEndpoint;  // State 3
+        }
+        return centerPoint;      // State 2 (both LOW), or both HIGH
+    }
 };
 
 #endif
@@ -1,9 +1,27 @@
-void loadChannels(){
-    // Load channel configurations
-    inputHandler.loadFromEEPROM();
+// Pin-specialized readers, one per entry of predefinedDevices (same order)
+const ChannelReader predefinedReaders[] PROGMEM = {
+    &Channel::readAnalogPin<A4>, &Channel::readAnalogPin<A5>, &Channel::readAnalogPin<A6>, &Channel::readAnalogPin<A7>,
+    &Channel::readAnalogPin<A0>, &Channel::readAnalogPin<A1>, &Channel::readAnalogPin<A2>, &Channel::readAnalogPin<A3>,
+    &Channel::readSwitchPins<2, 3>, &Channel::readSwitchPins<4, 5>,
+    &Channel::readDigitalPin<6>, &Channel::readDigitalPin<7>, &Channel::readDigitalPin<8>,
+    &Channel::readBackendAnalog, &Channel::readBackendAnalog, &Channel::readBackendAnalog, &Channel::readBackendAnalog,
+    &Channel::readBackendDigital, &Channel::readBackendDigital, &Channel::readBackendDigital, &Channel::readBackendDigital,
+    &Channel::readBackendDigital, &Channel::readBackendDigital, &Channel::readBackendDigital, &Channel::readBackendDigital
+};
+
+static_assert(sizeof(predefinedReaders) / sizeof(predefinedReaders[0]) ==
+              sizeof(predefinedDevices) / sizeof(predefinedDevices[0]),
+              "predefinedReaders must match predefinedDevices");
+
+// Configure the channels from the active model's configs in RAM
+void applyChannelConfigs(){
+    // Backends stay in use only if a channel is assigned to them below
+    for (InputBackend* backend : inputBackends) {
+        backend->unassign();
+    }
 
     // Configure channels dynamically
-    for (int i = 0; i < 10; ++i) {
+    for (int i = 0; i < MAX_CHANNELS; ++i) {
       ChannelConfig& config = inputHandler.channels[i];
       DeviceType deviceType = (DeviceType)config.deviceType;
 
@@ -19,6 +37,10 @@ void loadChannels(){
           case THREE_STATE_SWITCH:
               channels[i].setInputType(THREE_STATE);
               break;
+          case EXTERNAL_ANALOG:
+          case BANK_SWITCH:
+              channels[i].setInputType(ANALOG); // Pins are released by setBackend below
+              break;
           default:
               channels[i].setInputType(ANALOG); // Default to ANALOG
               break;
@@ -28,11 +50,20 @@ void loadChannels(){
       const PredefinedDevice* device = inputHandler.getPredefinedDevice(config.deviceType, config.deviceId);
       if (device != nullptr) {
           // Setup pins based on device requirements
-          if (deviceType == THREE_STATE_SWITCH) {
+          if (deviceType == EXTERNAL_ANALOG) {
+              channels[i].setBackend(&externalAdc, device->primaryPin); // Input on the I2C ADC
+          } else if (deviceType == BANK_SWITCH) {
+              channels[i].setBackend(&switchBank, device->primaryPin); // Bit of the switch bank
+          } else if (deviceType == THREE_STATE_SWITCH) {
               channels[i].setPin(device->primaryPin, device->secondaryPin); // Requires two pins
           } else {
               channels[i].setPin(device->primaryPin); // Requires one pin
           }
+
+          // Dispatch to the reader compiled for exactly this device's pins
+          ChannelReader reader;
+          memcpy_P(&reader, &predefinedReaders[device - predefinedDevices], sizeof(reader));
+          channels[i].setReader(reader);
       } else {
           // Default pin setup if no predefined device
           if (deviceType == THREE_STATE_SWITCH) {
@@ -40,6 +71,7 @@ void loadChannels(){
           } else {
               channels[i].setPin(A0 + i); // One pin for other types
           }
+          channels[i].setGenericReader();
       }
 
       // Set other properties from the config
@@ -50,4 +82,10 @@ void loadChannels(){
       channels[i].setMaxEndpoint(config.maxEndpoint);
 
     }
+
+    // Stop unused backends and restore the bus pins of the others, a channel that was on
+    // those pins before this reload may have changed their modes
+    for (InputBackend* backend : inputBackends) {
+        backend->settle();
+    }
 }
\ No newline at end of file
@@ -6,27 +6,203 @@
 #include <Arduino.h>  // For millis()
 #include <RF24.h>     // RF24 library for radio communication
 
+// Radio frames go out at a fixed period, serial commands are handled in between
+const unsigned long FRAME_PERIOD_US = 5000;
+
+// Serial link rates the config panel may negotiate with "B<baud>" (exact or <2.1% error
+// on a 16 MHz AVR with U2X). The link always starts at DEFAULT_BAUD_RATE.
+const unsigned long DEFAULT_BAUD_RATE = 9600;
+const uint32_t supportedBaudRates[] PROGMEM = {1000000, 500000, 250000, 115200, 57600, 9600};
+const unsigned long BAUD_PROBATION_MS = 250; // A new rate must pass the "K" echo test within this time
+const uint8_t MAX_LINK_ERRORS = 3;            // Garbled input at a negotiated rate before falling back
+
 class CommunicationHandler {
+#ifdef SIM_TIMING
+    friend void runTimingScript();
+#endif
+
 private:
     unsigned long lastSendTime; // Keeps track of the last send time
     ChannelValues* channelValues;   // Pointer to the struct holding the channel readings
     RF24* radio;             // Pointer to the RF24 instance for communication
+    FrameEncoder encoder;    // Packs channelValues into radio frames by rate class
+    SerialBridge bridge;     // Host channel input ("W")
+    ReceiverConfigLink configLink;  // Receiver config messages ("JR")
+
+    // Buffer for incoming serial data, room for the longest command
+    // ("V0=255,0,100,100,100,100,100,100" is 32 characters) with a margin
+    char commandBuffer[40];
+    uint8_t commandLength;
+
+    // Negotiated serial link state
+    unsigned long baudRate;
+    unsigned long baudChangeTime;   // When the current rate was switched to
+    bool baudProbation;             // Rate switched but not yet confirmed by an echo test
+    uint8_t linkErrors;             // Consecutive garbled bytes or unknown commands
+
+    // Boot metrics, micros() since reset
+    unsigned long firstFrameMicros; // First (failsafe) frame on the air
+    unsigned long readyMicros;      // Setup finished, frames carry live inputs from here
+
+    // Radio TX results, each frame's is collected at the next frame boundary ("JT")
+    enum TxPending : uint8_t {
+        TX_NONE,
+        TX_CONTROL,                 // A control frame, no ack requested
+        TX_CONFIG                   // A receiver config message, acked
+    };
+    TxPending txPending;            // What was loaded last and has no result collected yet
+    uint16_t txSent;                // Frames the radio reported as sent
+    uint16_t txLate;                // Still not sent at the next frame boundary
+    uint16_t txFailed;              // Reported as failed (max retransmits)
+    uint16_t txFifoFull;            // TX FIFO full when loading a frame, flushed
+    unsigned long controlAirEnd;    // micros() when the control frame loaded last is off the air
+
+#ifdef RC_LATENCY
+    unsigned long sampleMicros;     // First input sample of the current frame
+#endif
+
+    bool isSupportedBaudRate(unsigned long rate) {
+        for (uint8_t i = 0; i < sizeof(supportedBaudRates) / sizeof(supportedBaudRates[0]); i++) {
+            if (pgm_read_dword(&supportedBaudRates[i]) == rate) return true;
+        }
+        return false;
+    }
+
+    void setBaudRate(unsigned long rate) {
+        Serial.flush();  // Let the pending reply go out at the old rate
+        Serial.begin(rate);
+        baudRate = rate;
+        baudChangeTime = millis();
+        baudProbation = (rate != DEFAULT_BAUD_RATE);
+        linkErrors = 0;
+        commandLength = 0;
+    }
+
+    // A negotiated rate that garbles data (or was never confirmed) drops back to the default,
+    // which is also where a restarted config panel will be talking
+    void linkError() {
+        if (baudRate == DEFAULT_BAUD_RATE) return;
+        if (++linkErrors >= MAX_LINK_ERRORS) {
+            setBaudRate(DEFAULT_BAUD_RATE);
+        }
+    }
+
+    // Collect serial bytes into commandBuffer, processing at most one command per call so
+    // a burst of commands cannot push the next radio frame back
+    void serviceSerial() {
+        PROFILE_SCOPE(PROFILE_SERIAL);
+#ifdef RC_TRACE
+        if (inputTrace.replaying()) {
+            serviceReplay();
+            return;
+        }
+#endif
+        if (bridge.active) {
+            serviceBridge();
+            return;
+        }
+        while (Serial.available() > 0) {
+            if (receiveCommandByte(Serial.read())) break;
+        }
+
+        if (baudProbation && millis() - baudChangeTime > BAUD_PROBATION_MS) {
+            setBaudRate(DEFAULT_BAUD_RATE);  // The echo test never came, fall back
+        }
+    }
 
-    // Buffer for incoming serial data
-    String commandBuffer;
+    // Add one received byte to commandBuffer, true if it completed (and ran) a command
+    bool receiveCommandByte(char receivedChar) {
+        // Handle newline character
+        if (receivedChar == '\n') {
+            commandBuffer[commandLength] = '\0';
+            commandLength = 0;
+            processCommand(String(commandBuffer)); // Process the full command
+            return true;
+        } else if (receivedChar == '\r') {
+            return false;
+        } else if (receivedChar < 0x20 || receivedChar > 0x7E || commandLength >= sizeof(commandBuffer) - 1) {
+            // Commands are printable ASCII, anything else means the rates do not match
+            commandLength = 0;
+            linkError();
+        } else {
+            commandBuffer[commandLength++] = receivedChar; // Append character to buffer
+        }
+        return false;
+    }
+
+#ifdef RC_TRACE
+    // Replay: binary trace records instead of commands, one frame computed per call
+    void serviceReplay() {
+        while (Serial.available() > 0) {
+            InputTrace::FeedResult result = inputTrace.feed(Serial.read());
+            if (result == InputTrace::TRACE_SAMPLE) {
+                updateInputs();
+                inputTrace.sendFrame(Serial, *channelValues);
+                break;
+            } else if (result == InputTrace::TRACE_END) {
+                inputTrace.start(InputTrace::TRACE_OFF);
+                Serial.println(F("Y"));
+                break;
+            }
+        }
+    }
+#endif
+
+    // Bridge mode: binary channel records instead of commands, all that arrived is taken so
+    // the next frame carries the latest values
+    void serviceBridge() {
+        if (bridge.abandoned()) {
+            bridge.stop();  // Back to commands, the config panel or a new host can reach us again
+            return;
+        }
+        while (Serial.available() > 0) {
+            if (bridge.feed(Serial.read()) == SerialBridge::BRIDGE_END) {
+                bridge.stop();
+                Serial.println(F("Y"));
+                break;
+            }
+        }
+    }
 
     // Populate the channelValues structure with channel readings
     void updateInputs() {
-        channelValues->ch1 = channels[0].read();
-        channelValues->ch2 = channels[1].read();
-        channelValues->ch3 = channels[2].read();
-        channelValues->ch4 = channels[3].read();
-        channelValues->ch5 = channels[4].read();
-        channelValues->ch6 = channels[5].read();
-        channelValues->ch7 = channels[6].read();
-        channelValues->ch8 = channels[7].read();
-        channelValues->ch9 = channels[8].read();
-        channelValues->ch10 = channels[9].read();
+        PROFILE_SCOPE(PROFILE_INPUTS);
+#ifdef RC_TRACE
+        if (inputTrace.takeRestart()) digitalInputs.begin();
+#endif
+#ifdef RC_LATENCY
+        sampleMicros = micros();
+#endif
+        digitalInputs.sample();  // One port snapshot per frame for every switch channel
+        readInputs();
+    }
+
+    // Read every channel through the curves and the mixer, switches at their debounced state
+    void readInputs() {
+        channelValues->modelId = modelStore.activeModel;
+        for (uint8_t i = 0; i < MAX_CHANNELS; ++i) {
+            channelValues->values[i] = channels[i].read();
+        }
+
+        // Expo/rate curves, then the mix stage, between input reading and frame encoding
+        curves.apply(channelValues->values, MAX_CHANNELS);
+        mixer.apply(channelValues->values, MAX_CHANNELS);
+
+        bridge.apply(channelValues->values);  // Host input last, it stands for the finished output
+    }
+
+    // Parse up to maxValues comma-separated integers, returns how many were found
+    static uint8_t parseValues(const char* text, long* values, uint8_t maxValues) {
+        uint8_t count = 0;
+        while (count < maxValues) {
+            char* end;
+            values[count] = strtol(text, &end, 10);
+            if (end == text) break;
+            count++;
+            if (*end != ',') break;
+            text = end + 1;
+        }
+        return count;
     }
 
     // Send channel updates over serial
@@ -36,24 +212,110 @@ private:
 
     // Send channel configuration over serial
     void sendChannelConfig(int channelIndex) {
-        if (channelIndex >= 0 && channelIndex < 10) {
+        if (channelIndex >= 0 && channelIndex < MAX_CHANNELS) {
             Serial.write((uint8_t*)&inputHandler.channels[channelIndex], sizeof(ChannelConfig));
         } else {
             Serial.println(F("Invalid channel index"));
         }
     }
 
+    // Send the global and per-channel config generations over serial
+    void sendGenerations() {
+        Serial.write((uint8_t*)&inputHandler.globalGeneration, sizeof(inputHandler.globalGeneration));
+        Serial.write((uint8_t*)inputHandler.generation, sizeof(inputHandler.generation));
+    }
+
+    // Persist a changed channel config and apply it
+    void commitChannel(int channelIndex) {
+        inputHandler.markChanged(channelIndex);
+        modelStore.saveChannels();
+        applyChannelConfigs();
+    }
+
     // Send channel updates over the radio
     void sendRadioUpdates() {
+        PROFILE_SCOPE(PROFILE_RADIO);
+        RadioFrame frame;
+#ifdef RC_LATENCY
+        // Stamp the frame with the age of its inputs for the receiver's latency report
+        uint8_t length = encoder.encode(*channelValues, inputHandler.rateClass, inputHandler.keyframeInterval, frame, true);
+        stampFrame(frame, length, (uint16_t)min(micros() - sampleMicros, 0xFFFFUL));
+#else
+        uint8_t length = encoder.encode(*channelValues, inputHandler.rateClass, inputHandler.keyframeInterval, frame);
+#endif
         if (radio) {
-            radio->write(channelValues, sizeof(ChannelValues));
+            collectTxResult();
+            if (radio->isFifo(true, false)) {
+                // Frames are stuck (radio hung or unplugged), drop them rather than send stale ones
+                saturatingIncrement(txFifoFull);
+                radio->flush_tx();
+            }
+            // Load the FIFO and return, the radio sends it while the loop samples inputs and
+            // serves the serial link. No ack requested, CE stays high between frames.
+            radio->startFastWrite(&frame, length, true);
+            controlAirEnd = micros() + rcFrameAirtime(length);
+            txPending = TX_CONTROL;
         }
     }
 
+    // After a control frame is off the air: the next receiver config message, with an
+    // ack request (the receiver's status comes back as ack payload)
+    void sendConfigMessage() {
+        if (!radio) return;
+        collectTxResult();
+        RadioFrame frame;
+        uint8_t length = configLink.message(modelStore.activeModel, frame);
+        radio->startFastWrite(&frame, length, false);
+        txPending = TX_CONFIG;
+    }
+
+    // Status of the frame loaded last: by now it should long be on the air
+    void collectTxResult() {
+        if (txPending == TX_NONE) return;
+        bool sent, failed, received;
+        radio->whatHappened(sent, failed, received);  // Also clears the flags
+
+        if (txPending == TX_CONFIG) {
+            ReceiverStatus status;
+            bool hasStatus = false;
+            if (received) {
+                hasStatus = radio->getDynamicPayloadSize() == sizeof(status);
+                radio->read(&status, sizeof(status));
+            }
+            if (!sent) radio->flush_tx();  // Not acked, the message would block the FIFO
+            configLink.onResult(sent, hasStatus ? &status : nullptr);
+        } else if (sent) {
+            saturatingIncrement(txSent);
+        } else if (failed) {
+            saturatingIncrement(txFailed);
+        } else {
+            saturatingIncrement(txLate);
+        }
+        txPending = TX_NONE;
+    }
+
+    // Parse hex digit pairs into bytes, returns how many or 0 on a bad digit
+    static uint8_t parseHex(const char* text, uint8_t* bytes, uint8_t maxBytes) {
+        uint8_t count = 0;
+        while (text[0] && text[1] && count < maxBytes) {
+            char pair[3] = {text[0], text[1], '\0'};
+            char* end;
+            bytes[count++] = strtoul(pair, &end, 16);
+            if (end != pair + 2) return 0;
+            text += 2;
+        }
+        return *text ? 0 : count;
+    }
+
+    static void saturatingIncrement(uint16_t& counter) {
+        if (counter != 0xFFFF) counter++;
+    }
+
     // Process the received command
     void processCommand(const String& command) {
+        PROFILE_SCOPE(PROFILE_COMMAND);
         if (command == "X") {
-            updateInputs();     // Update the channel values
+            readInputs();       // Current values, the debouncer only steps once per frame
             sendSerialUpdates(); // Send data over Serial
         } else if (command.startsWith("A")) {
             // Parse the channel index, e.g., "C0", "C5"
@@ -61,6 +323,283 @@ private:
             uint16_t analogValue = channels[channelIndex].getAnalogValue();  // Fixed semicolon
             Serial.write((uint8_t*)&analogValue, sizeof(analogValue));  // Send the 2-byte value
 
+        } else if (command.startsWith("B")) {
+            // Format: "B<baud>", switch the serial link rate after acknowledging at the old one
+            unsigned long rate = command.substring(1).toInt();
+            if (isSupportedBaudRate(rate)) {
+                Serial.println(F("Y"));
+                setBaudRate(rate);
+            } else {
+                Serial.println(F("N"));
+            }
+        } else if (command.startsWith("K")) {
+            // Format: "K<pattern>", echo test confirming the negotiated rate
+            Serial.println(command.c_str() + 1);
+            baudProbation = false;
+            linkErrors = 0;
+        } else if (command == "MS") {
+            // Mixer cost: last and longest apply() in microseconds
+            Serial.write((uint8_t*)&mixer.lastMicros, sizeof(mixer.lastMicros));
+            Serial.write((uint8_t*)&mixer.maxMicros, sizeof(mixer.maxMicros));
+        } else if (command.startsWith("M")) {
+            // Format: "M<rule>" reads a MixRule, "M<rule>=<src>,<dst>,<weight>,<offset>,<curve>,<mode>" sets it
+            int equalIndex = command.indexOf('=');
+            int ruleIndex = command.substring(1, equalIndex == -1 ? command.length() : equalIndex).toInt();
+
+            if (equalIndex == -1) {
+                if (ruleIndex >= 0 && ruleIndex < MAX_MIXES) {
+                    Serial.write((uint8_t*)&mixer.config.rules[ruleIndex], sizeof(MixRule));
+                } else {
+                    Serial.println(F("N"));
+                }
+            } else {
+                long values[6];
+                bool valid = parseValues(command.c_str() + equalIndex + 1, values, 6) == 6;
+                for (int i = 0; valid && i < 6; i++) {
+                    valid = values[i] >= -128 && values[i] <= 255;  // Range checks happen in setRule
+                }
+
+                if (valid) {
+                    MixRule rule = {(uint8_t)values[0], (uint8_t)values[1], (int8_t)values[2],
+                                    (int8_t)values[3], (uint8_t)values[4], (uint8_t)values[5]};
+                    valid = (values[2] >= -100 && values[2] <= 100 && values[3] >= -100 && values[3] <= 100) &&
+                            mixer.setRule(ruleIndex, rule, MAX_CHANNELS);
+                }
+
+                if (valid) {
+                    modelStore.saveMixer();
+                    Serial.println(F("Y"));
+                } else {
+                    Serial.println(F("N"));
+                }
+            }
+        } else if (command.startsWith("U")) {
+            // Format: "U<curve>" reads a mix curve (1-based), "U<curve>=<p0>,<p1>,<p2>,<p3>,<p4>" sets it (percent)
+            int equalIndex = command.indexOf('=');
+            int curveIndex = command.substring(1, equalIndex == -1 ? command.length() : equalIndex).toInt() - 1;
+
+            if (curveIndex < 0 || curveIndex >= MAX_MIX_CURVES) {
+                Serial.println(F("N"));
+            } else if (equalIndex == -1) {
+                Serial.write((uint8_t*)mixer.config.curves[curveIndex], MIX_CURVE_POINTS);
+            } else {
+                long values[MIX_CURVE_POINTS];
+                bool valid = parseValues(command.c_str() + equalIndex + 1, values, MIX_CURVE_POINTS) == MIX_CURVE_POINTS;
+                for (int i = 0; valid && i < MIX_CURVE_POINTS; i++) {
+                    valid = values[i] >= -100 && values[i] <= 100;
+                }
+                if (valid) {
+                    for (int i = 0; i < MIX_CURVE_POINTS; i++) {
+                        mixer.config.curves[curveIndex][i] = values[i];
+                    }
+                    modelStore.saveMixer();
+                    curves.rebuild(mixer.config);  // Channel curves may use this shape
+                    Serial.println(F("Y"));
+                } else {
+                    Serial.println(F("N"));
+                }
+            }
+        } else if (command.startsWith("V")) {
+            // Format: "V<ch>" reads a ChannelCurveConfig,
+            // "V<ch>=<rateSwitch>,<curve>,<rate0>,<expo0>,<rate1>,<expo1>,<rate2>,<expo2>" sets it
+            int equalIndex = command.indexOf('=');
+            int channelIndex = command.substring(1, equalIndex == -1 ? command.length() : equalIndex).toInt();
+
+            if (channelIndex < 0 || channelIndex >= MAX_CHANNELS) {
+                Serial.println(F("N"));
+            } else if (equalIndex == -1) {
+                Serial.write((uint8_t*)&curves.config.channels[channelIndex], sizeof(ChannelCurveConfig));
+            } else {
+                long values[2 + 2 * RATE_SETS];
+                bool valid = parseValues(command.c_str() + equalIndex + 1, values, 2 + 2 * RATE_SETS) == 2 + 2 * RATE_SETS;
+                for (int i = 0; valid && i < 2 + 2 * RATE_SETS; i++) {
+                    valid = values[i] >= 0 && values[i] <= 255;
+                }
+
+                ChannelCurveConfig curveConfig;
+                if (valid) {
+                    curveConfig.rateSwitch = values[0];
+                    curveConfig.curve = values[1];
+                    for (int r = 0; r < RATE_SETS; r++) {
+                        curveConfig.rates[r] = {(uint8_t)values[2 + r * 2], (uint8_t)values[3 + r * 2]};
+                    }
+                    valid = CurveHandler::isValid(curveConfig);
+                }
+
+                if (valid) {
+                    ChannelCurveConfig previous = curves.config.channels[channelIndex];
+                    curves.config.channels[channelIndex] = curveConfig;
+                    if (curves.rebuild(mixer.config)) {
+                        modelStore.saveCurves();
+                        Serial.println(F("Y"));
+                    } else {
+                        // Out of lookup tables, keep the previous curve
+                        curves.config.channels[channelIndex] = previous;
+                        curves.rebuild(mixer.config);
+                        Serial.println(F("N"));
+                    }
+                } else {
+                    Serial.println(F("N"));
+                }
+            }
+        } else if (command == "L") {
+            // Active model, number of slots, how long the last switch took (us) and the slot
+            // still being written in the background (a copy or a reset), 0xFF if none
+            Serial.write(modelStore.activeModel);
+            Serial.write(MODEL_SLOTS);
+            Serial.write((uint8_t*)&modelStore.switchMicros, sizeof(modelStore.switchMicros));
+            Serial.write(modelStore.savingSlot());
+        } else if (command.startsWith("LC")) {
+            // Format: "LC<slot>" starts copying the active model into another slot, "L"
+            // shows when it is done
+            long values[1];
+            bool copied = parseValues(command.c_str() + 2, values, 1) == 1 && values[0] >= 0 && values[0] < MODEL_SLOTS &&
+                          modelStore.copyTo(values[0]);
+            Serial.println(copied ? F("Y") : F("N"));
+        } else if (command.startsWith("L")) {
+            // Format: "L<slot>" switches to another model
+            long values[1];
+            bool switched = parseValues(command.c_str() + 1, values, 1) == 1 && values[0] >= 0 && values[0] < MODEL_SLOTS &&
+                            modelStore.select(values[0]);
+            Serial.println(switched ? F("Y") : F("N"));
+        } else if (command == "F") {
+            Serial.write(inputHandler.failsafe, MAX_CHANNELS);  // Failsafe values of the active model
+        } else if (command == "FS") {
+            // Take the current stick and switch positions as failsafe values
+            memcpy(inputHandler.failsafe, channelValues->values, MAX_CHANNELS);
+            modelStore.saveFailsafes();
+            Serial.println(F("Y"));
+        } else if (command.startsWith("F")) {
+            // Format: "F<ch>=<value>" sets one failsafe value
+            long values[2];
+            int equalIndex = command.indexOf('=');
+            int channelIndex = command.substring(1, equalIndex).toInt();
+            if (equalIndex != -1 && channelIndex >= 0 && channelIndex < MAX_CHANNELS &&
+                parseValues(command.c_str() + equalIndex + 1, values, 1) == 1 && values[0] >= 0 && values[0] <= 255) {
+                inputHandler.failsafe[channelIndex] = values[0];
+                modelStore.saveFailsafes();
+                Serial.println(F("Y"));
+            } else {
+                Serial.println(F("N"));
+            }
+        } else if (command == "J") {
+            Serial.write(inputHandler.rateClass, MAX_CHANNELS);  // Radio rate class of every channel
+        } else if (command == "JT") {
+            // Radio TX counters: sent, late, failed and FIFO full frames (uint16 each, saturating)
+            Serial.write((uint8_t*)&txSent, sizeof(txSent));
+            Serial.write((uint8_t*)&txLate, sizeof(txLate));
+            Serial.write((uint8_t*)&txFailed, sizeof(txFailed));
+            Serial.write((uint8_t*)&txFifoFull, sizeof(txFifoFull));
+        } else if (command == "JR") {
+            // Receiver config link: state, messages sent, then the receiver's last ReceiverStatus
+            Serial.write(configLink.state);
+            Serial.write((uint8_t*)&configLink.attempts, sizeof(configLink.attempts));
+            Serial.write((uint8_t*)&configLink.receiver, sizeof(configLink.receiver));
+        } else if (command == "JRS") {
+            // Send the staged receiver config over the air
+            Serial.println(configLink.start() ? F("Y") : F("N"));
+        } else if (command.startsWith("JR")) {
+            // Format: "JR<offset>=<hex bytes>" stages part of a ReceiverConfig
+            uint8_t bytes[RC_CONFIG_CHUNK];
+            int equalIndex = command.indexOf('=');
+            int offset = command.substring(2, equalIndex).toInt();
+            uint8_t size = equalIndex == -1 ? 0 : parseHex(command.c_str() + equalIndex + 1, bytes, sizeof(bytes));
+            bool staged = size > 0 && offset >= 0 && offset < RC_RECEIVER_CONFIG_SIZE && configLink.stage(offset, bytes, size);
+            Serial.println(staged ? F("Y") : F("N"));
+        } else if (command == "JD") {
+            Serial.write(inputHandler.keyframeInterval);  // Delta mode keyframe interval, 0 when off
+        } else if (command.startsWith("JD=")) {
+            // Format: "JD=<frames>" turns delta frames on with a keyframe every <frames> frames, "JD=0" off
+            long values[1];
+            if (parseValues(command.c_str() + 3, values, 1) == 1 && values[0] >= 0 && values[0] <= 255) {
+                inputHandler.keyframeInterval = values[0];
+                modelStore.saveRateClasses();
+                Serial.println(F("Y"));
+            } else {
+                Serial.println(F("N"));
+            }
+        } else if (command.startsWith("J")) {
+            // Format: "J<ch>=<class>" sets how often a channel is sent (RateClass in RCFrame.h)
+            long values[1];
+            int equalIndex = command.indexOf('=');
+            int channelIndex = command.substring(1, equalIndex).toInt();
+            if (equalIndex != -1 && channelIndex >= 0 && channelIndex < MAX_CHANNELS &&
+                parseValues(command.c_str() + equalIndex + 1, values, 1) == 1 && values[0] >= 0 && values[0] < RATE_CLASSES) {
+                inputHandler.rateClass[channelIndex] = values[0];
+                modelStore.saveRateClasses();
+                Serial.println(F("Y"));
+            } else {
+                Serial.println(F("N"));
+            }
+        } else if (command == "Q") {
+            // Boot metrics: time to the first frame and to live inputs (us since reset), and the
+            // stack high-water mark
+            Serial.write((uint8_t*)&firstFrameMicros, sizeof(firstFrameMicros));
+            Serial.write((uint8_t*)&readyMicros, sizeof(readyMicros));
+            uint16_t stackBytes = unusedStack();  // Least free stack since boot
+            Serial.write((uint8_t*)&stackBytes, sizeof(stackBytes));
+        } else if (command.startsWith("P")) {
+            // "P" sends the profiling report (tools/profile_decode.py), "PZ" clears it
+#ifdef RC_PROFILE
+            if (command == "PZ") {
+                profiler.reset();
+                Serial.println(F("Y"));
+            } else {
+                profiler.report(Serial);
+            }
+#else
+            Serial.println(F("N"));  // Built without RC_PROFILE
+#endif
+        } else if (command.startsWith("O")) {
+            // Input trace (tools/trace.py): "OR" records, "OP" replays, "OX" stops recording
+#ifdef RC_TRACE
+            if (command == "OR" || command == "OP" || command == "OX") {
+                Serial.println(F("Y"));
+                inputTrace.start(command == "OR" ? InputTrace::TRACE_RECORD :
+                                 command == "OP" ? InputTrace::TRACE_REPLAY : InputTrace::TRACE_OFF);
+            } else {
+                Serial.println(F("N"));
+            }
+#else
+            Serial.println(F("N"));  // Built without RC_TRACE
+#endif
+        } else if (command.startsWith("S")) {
+            // Round-trip latency loopback: "SL<channel>" starts it on the channel under test,
+            // "S" reports, "SZ" clears the results, "SX" stops it and sets up the S2 switch again
+#ifdef RC_LATENCY
+            if (command.startsWith("SL") && command.length() > 2 &&
+                LatencyLoopback::canTest(command.substring(2).toInt())) {
+                latencyLoopback.begin(command.substring(2).toInt());
+                Serial.println(F("Y"));
+            } else if (command == "SX" && latencyLoopback.isRunning()) {
+                latencyLoopback.end();
+                applyChannelConfigs();
+                Serial.println(F("Y"));
+            } else if (command == "SZ") {
+                latencyLoopback.stats.reset();
+                Serial.println(F("Y"));
+            } else if (command == "S" && latencyLoopback.isRunning()) {
+                latencyLoopback.stats.report(Serial, F("loopback"));
+            } else {
+                Serial.println(F("N"));
+            }
+#else
+            Serial.println(F("N"));  // Built without RC_LATENCY
+#endif
+        } else if (command == "W") {
+            // Bridge mode (SerialBridge.h): binary channel records follow until an 'E' record
+            Serial.println(F("Y"));
+            bridge.start();
+        } else if (command == "WS") {
+            // Bridge counters: valid records, dropped records, stream stalls (uint16 each).
+            // A stall of BRIDGE_EXIT_MS also ends bridge mode.
+            Serial.write((uint8_t*)&bridge.frames, sizeof(bridge.frames));
+            Serial.write((uint8_t*)&bridge.errors, sizeof(bridge.errors));
+            Serial.write((uint8_t*)&bridge.timeouts, sizeof(bridge.timeouts));
+        } else if (command == "H") {
+            Serial.write(RC_SCHEMA_VERSION); // Lets the config panel refuse configs it cannot decode
+        } else if (command == "G") {
+            sendGenerations(); // Let the config panel find out which cached configs are stale
         } else if (command.startsWith("C")) {
             // Parse the channel index, e.g., "C0", "C5"
             int channelIndex = command.substring(1).toInt();
@@ -72,15 +611,21 @@ private:
                 int channelIndex = command.substring(1, equalIndex).toInt();
                 int deviceIndex = command.substring(equalIndex + 1).toInt();  // Extract the deviceIndex after '='
 
-                if (channelIndex >= 0 && channelIndex < 10) {
+                const int deviceCount = sizeof(predefinedDevices) / sizeof(predefinedDevices[0]);
+                if (channelIndex >= 0 && channelIndex < MAX_CHANNELS && deviceIndex >= 0 && deviceIndex < deviceCount) {
                     // Apply the received deviceIndex to the corresponding channel
-                    inputHandler.channels[channelIndex].deviceType = predefinedDevices[deviceIndex].type;
-                    inputHandler.channels[channelIndex].deviceId = predefinedDevices[deviceIndex].id;
+                    ChannelConfig& config = inputHandler.channels[channelIndex];
+                    ChannelConfig previous = config;
+                    config.deviceType = predefinedDevices[deviceIndex].type;
+                    config.deviceId = predefinedDevices[deviceIndex].id;
 
-                    inputHandler.saveToEEPROM();
-                    loadChannels();
-
-                    Serial.println(F("Y"));
+                    if (inputHandler.sharesBackendPins(channelIndex)) {
+                        config = previous;  // D1-D3 or J1/J2 while another channel uses their backend
+                        Serial.println(F("N"));
+                    } else {
+                        commitChannel(channelIndex);
+                        Serial.println(F("Y"));
+                    }
                 } else {
                     Serial.println(F("N"));
                 }
@@ -90,7 +635,7 @@ private:
         }  else if (command.startsWith("I")) {
             // Handle the "I<channel index>" format
             int channelIndex = command.substring(1).toInt();
-            if (channelIndex >= 0 && channelIndex < 10) {
+            if (channelIndex >= 0 && channelIndex < MAX_CHANNELS) {
                 Serial.println(inputHandler.channels[channelIndex].reverse);
             } else {
                 Serial.println(F("Invalid channel index for I command"));
@@ -98,12 +643,11 @@ private:
         } else if (command.startsWith("R")) {
             // Handle the "R<channel index>" format to reverse the channel
             int channelIndex = command.substring(1).toInt();
-            if (channelIndex >= 0 && channelIndex < 10) {
+            if (channelIndex >= 0 && channelIndex < MAX_CHANNELS) {
                 bool isReversed = inputHandler.channels[channelIndex].reverse;  // Check if channel is already reversed
                 inputHandler.channels[channelIndex].reverse = !isReversed;        // Toggle the reverse state
                 
-                inputHandler.saveToEEPROM();
-                loadChannels();
+                commitChannel(channelIndex);
 
                 Serial.println(F("Y"));
             } else {
@@ -120,14 +664,13 @@ private:
                 uint16_t analogReadMax = command.substring(secondComma + 1).toInt();  // Extract max endpoint
 
                 // Validate the channel index
-                if (channelIndex >= 0 && channelIndex < 10) {
+                if (channelIndex >= 0 && channelIndex < MAX_CHANNELS) {
                     // Apply calibration data to the specified channel
                     inputHandler.channels[channelIndex].analogReadMin = analogReadMin;
                     inputHandler.channels[channelIndex].analogReadMax = analogReadMax;
 
-                    // Optionally save to EEPROM and reload
-                    inputHandler.saveToEEPROM();
-                    loadChannels();
+                    // Save to EEPROM and reload
+                    commitChannel(channelIndex);
 
                     Serial.println(F("Y"));  // Acknowledge successful update
                 } else {
@@ -144,13 +687,12 @@ private:
                 int8_t trimValue = command.substring(commaIndex + 1).toInt();  // Extract trim value
 
                 // Validate the channel index and trim value range
-                if (channelIndex >= 0 && channelIndex < 10 && trimValue >= -127 && trimValue <= 127) {
+                if (channelIndex >= 0 && channelIndex < MAX_CHANNELS && trimValue >= -127 && trimValue <= 127) {
                     // Set the trim value for the specified channel
                     inputHandler.channels[channelIndex].trim = trimValue;
 
-                    // Optionally save to EEPROM and reload
-                    inputHandler.saveToEEPROM();
-                    loadChannels();
+                    // Save to EEPROM and reload
+                    commitChannel(channelIndex);
 
                     Serial.println(F("Y"));  // Acknowledge successful update
                 } else {
@@ -165,11 +707,10 @@ private:
             if (commaIndex != -1) {
                 int channelIndex = command.substring(1, commaIndex).toInt();  // Extract channel index
                 uint16_t minEndpoint = command.substring(commaIndex + 1).toInt();  // Extract min endpoint
-                if (channelIndex >= 0 && channelIndex < 10) {
+                if (channelIndex >= 0 && channelIndex < MAX_CHANNELS) {
                     inputHandler.channels[channelIndex].minEndpoint = minEndpoint;
                     inputHandler.channels[channelIndex].maxEndpoint = 255 - minEndpoint;
-                    inputHandler.saveToEEPROM();
-                    loadChannels();
+                    commitChannel(channelIndex);
                     Serial.println(F("Y"));  // Acknowledge successful update
                 } else {
                     Serial.println(F("N"));  // Invalid channel index
@@ -179,6 +720,7 @@ private:
             }
         } else {
             Serial.println(F("N"));
+            linkError();
         }
         // Add more commands as needed here
     }
@@ -186,26 +728,66 @@ private:
 public:
     // Constructor
     CommunicationHandler(ChannelValues* dataStruct, RF24* rfModule)
-        : lastSendTime(0), channelValues(dataStruct), radio(rfModule) {}
+        : lastSendTime(0), channelValues(dataStruct), radio(rfModule), commandLength(0),
+          baudRate(DEFAULT_BAUD_RATE), baudChangeTime(0), baudProbation(false), linkErrors(0),
+          firstFrameMicros(0), readyMicros(0),
+          txPending(TX_NONE), txSent(0), txLate(0), txFailed(0), txFifoFull(0), controlAirEnd(0) {}
+
+    // Put the active model's failsafe values on the air, before the inputs are set up
+    void sendFailsafeFrame() {
+        channelValues->modelId = modelStore.activeModel;
+        memcpy(channelValues->values, inputHandler.failsafe, MAX_CHANNELS);
+#ifdef RC_LATENCY
+        sampleMicros = micros();
+#endif
+        sendRadioUpdates();
+        lastSendTime = micros();
+        if (firstFrameMicros == 0) firstFrameMicros = lastSendTime;
+    }
+
+    // Setup is done, regular frames follow
+    void markReady() {
+        readyMicros = micros();
+    }
+
+    // Open the serial link at the default rate
+    void begin() {
+        Serial.begin(DEFAULT_BAUD_RATE);
+        Serial.setTimeout(10);
+    }
 
     // Loop method to handle communication
     void loop() {
         // Check for serial input
-        while (Serial.available() > 0) {
-            char receivedChar = Serial.read();
-            
-            // Handle newline character
-            if (receivedChar == '\n') {
-                processCommand(commandBuffer); // Process the full command
-                commandBuffer = "";            // Clear the buffer
-            } else if (receivedChar != '\r') {
-                commandBuffer += receivedChar; // Append character to buffer
+        serviceSerial();
+
+#ifdef RC_TRACE
+        if (inputTrace.replaying()) return;  // Frames only come from replayed samples and stay off the air
+#endif
+
+        // Send updates over the radio once per frame period
+        unsigned long now = micros();
+        if (now - lastSendTime >= FRAME_PERIOD_US) {
+            PROFILE_SCOPE(PROFILE_FRAME);
+            lastSendTime = now;
+            updateInputs();   // Update the channel values
+            sendRadioUpdates();
+#ifdef RC_TRACE
+            if (inputTrace.recording()) inputTrace.record(Serial, *channelValues);
+#endif
+        } else if (FRAME_PERIOD_US - (now - lastSendTime) > BACKEND_GUARD_US) {
+            // A pending receiver config message goes out once per frame, after the control
+            // frame (however long the inputs took) and only if it cannot overlap the next one
+            if (configLink.pending() && txPending == TX_CONTROL && (long)(now - controlAirEnd) >= 0 &&
+                FRAME_PERIOD_US - (now - lastSendTime) >= CONFIG_AIRTIME_US) {
+                sendConfigMessage();
+            }
+            // Fetch external inputs and write pending model data in the idle time between frames
+            for (InputBackend* backend : inputBackends) {
+                backend->poll(now);
             }
+            modelStore.service();
         }
-
-        // Always send updates over the radio
-        updateInputs();   // Update the channel values
-        sendRadioUpdates();
     }
 };
 
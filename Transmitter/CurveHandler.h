@@ -0,0 +1,169 @@
+#ifndef CURVE_HANDLER_H
+#define CURVE_HANDLER_H
+
+#include <Arduino.h>
+#include <EEPROM.h>
+
+// Curve limits and storage
+const int RATE_SETS = 3;                  // Dual/triple rates
+const int CURVE_TABLE_POINTS = 17;        // Output at inputs 0, 16, ..., 240, 256
+const int MAX_CURVE_TABLES = 12;          // Shared pool, identity curves need no table
+const uint8_t CURVE_VERSION = 1;          // Increment this when structure changes
+
+const uint8_t NO_RATE_SWITCH = 0xFF;      // Always use rate set 0
+const uint8_t NO_CURVE_TABLE = 0xFF;      // Identity, the value passes through
+
+// One selectable response: custom shape (or expo) scaled to a rate
+struct RateSet {
+    uint8_t rate;   // Percent of full throw, 0 to 100
+    uint8_t expo;   // Percent, 0 (linear) to 100 (cubic), softens the center
+};
+
+// Per-channel curve configuration
+struct ChannelCurveConfig {
+    uint8_t rateSwitch;          // Channel whose position selects the rate set, NO_RATE_SWITCH for set 0
+    uint8_t curve;               // 0 = expo, 1..MAX_MIX_CURVES = the mixer's multi-point curve
+    RateSet rates[RATE_SETS];
+};
+
+struct CurveConfig {
+    uint8_t version;
+    ChannelCurveConfig channels[MAX_CHANNELS];
+};
+
+// CurveHandler Class
+//
+// Expo, multi-point curves and rates are turned into 17-point lookup tables whenever the
+// config changes (integer math, a full rebuild stays well inside one frame period so a
+// model switch is not delayed). Per frame each channel costs one table lookup plus a
+// linear interpolation, and a rate switch just swaps which table pointer is active.
+class CurveHandler {
+public:
+    CurveConfig config;
+
+    // Check the config just read from EEPROM and build the tables, custom curves take
+    // their points from the mixer
+    void validate(const MixerConfig& mixerConfig) {
+        if (config.version != CURVE_VERSION) {
+            reset();
+        }
+        rebuild(mixerConfig);
+    }
+
+    // Save to EEPROM
+    void saveToEEPROM(int address) {
+        EEPROM.put(address, config);
+    }
+
+    // Linear full-rate response on every channel
+    void reset() {
+        config.version = CURVE_VERSION;
+        for (int i = 0; i < MAX_CHANNELS; ++i) {
+            config.channels[i].rateSwitch = NO_RATE_SWITCH;
+            config.channels[i].curve = 0;
+            for (int r = 0; r < RATE_SETS; ++r) {
+                config.channels[i].rates[r] = {100, 0};
+            }
+        }
+    }
+
+    // Validate a channel's curve config
+    static bool isValid(const ChannelCurveConfig& curveConfig) {
+        if (curveConfig.rateSwitch != NO_RATE_SWITCH && curveConfig.rateSwitch >= MAX_CHANNELS) return false;
+        if (curveConfig.curve > MAX_MIX_CURVES) return false;
+        for (int r = 0; r < RATE_SETS; ++r) {
+            if (curveConfig.rates[r].rate > 100 || curveConfig.rates[r].expo > 100) return false;
+        }
+        return true;
+    }
+
+    // Recompute every lookup table, false if the pool is too small (those curves stay linear)
+    bool rebuild(const MixerConfig& mixerConfig) {
+        uint8_t used = 0;
+        bool fits = true;
+
+        for (int i = 0; i < MAX_CHANNELS; ++i) {
+            const ChannelCurveConfig& curveConfig = config.channels[i];
+            for (int r = 0; r < RATE_SETS; ++r) {
+                const RateSet& rateSet = curveConfig.rates[r];
+                tableIndex[i][r] = NO_CURVE_TABLE;
+
+                if (curveConfig.curve == 0 && rateSet.rate == 100 && rateSet.expo == 0) continue;
+                if (used >= MAX_CURVE_TABLES) {
+                    fits = false;
+                    continue;
+                }
+
+                const int8_t* points = curveConfig.curve ? mixerConfig.curves[curveConfig.curve - 1] : nullptr;
+                buildTable(tables[used], points, rateSet);
+                tableIndex[i][r] = used++;
+            }
+            selectRate(i, 0);
+        }
+        return fits;
+    }
+
+    // Apply each channel's active curve to values (0-255) in place
+    void apply(uint8_t* values, uint8_t channelCount) {
+        // Rate switches are read before any value is curved
+        for (uint8_t i = 0; i < channelCount; ++i) {
+            uint8_t rateSwitch = config.channels[i].rateSwitch;
+            if (rateSwitch != NO_RATE_SWITCH) {
+                uint8_t position = values[rateSwitch];
+                selectRate(i, position < 85 ? 0 : (position < 170 ? 1 : 2));
+            }
+        }
+
+        for (uint8_t i = 0; i < channelCount; ++i) {
+            const uint8_t* table = activeTable[i];
+            if (table == nullptr) continue;
+
+            uint8_t value = values[i];
+            if (value == 255) {
+                values[i] = table[CURVE_TABLE_POINTS - 1];  // Top end of the last segment
+                continue;
+            }
+            uint8_t index = value >> 4;
+            uint8_t fraction = value & 0x0F;
+            int16_t y0 = table[index];
+            int16_t y1 = table[index + 1];
+            values[i] = y0 + (((y1 - y0) * fraction) >> 4);
+        }
+    }
+
+private:
+    uint8_t tables[MAX_CURVE_TABLES][CURVE_TABLE_POINTS];
+    uint8_t tableIndex[MAX_CHANNELS][RATE_SETS];
+    const uint8_t* activeTable[MAX_CHANNELS];  // nullptr = identity
+
+    void selectRate(uint8_t channel, uint8_t rateSet) {
+        uint8_t index = tableIndex[channel][rateSet];
+        activeTable[channel] = (index == NO_CURVE_TABLE) ? nullptr : tables[index];
+    }
+
+    // points: the 5 points of a multi-point curve (percent at x = -1, -0.5, 0, 0.5, 1), nullptr for expo
+    void buildTable(uint8_t* table, const int8_t* points, const RateSet& rateSet) {
+        int32_t expo = rateSet.expo;
+        int32_t rate = rateSet.rate;
+
+        for (int p = 0; p < CURVE_TABLE_POINTS; ++p) {
+            int32_t x = p * 16 - 128;  // -128 to +128 = -1 to +1
+            int32_t output;
+            if (points == nullptr) {
+                // y = x * (1 - expo) + x^3 * expo, in 1/128 * 1/100 units
+                int32_t y = x * (100 - expo) + (x * x * x * expo) / 16384;
+                output = (1285000 + y * rate) / 10000;  // 128 + y * rate, rounded (never negative)
+            } else {
+                // 64 input steps per segment, y in percent * 64
+                int32_t position = x + 128;
+                int segment = min((int)(position >> 6), MIX_CURVE_POINTS - 2);
+                int32_t fraction = position - segment * 64;
+                int32_t y = points[segment] * 64 + (points[segment + 1] - points[segment]) * fraction;
+                output = (642500 + y * rate) / 5000;  // 128 + y * rate * 128 / (64 * 10000), rounded
+            }
+            table[p] = constrain(output, 0, 255);
+        }
+    }
+};
+
+#endif
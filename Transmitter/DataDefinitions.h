@@ -7,22 +7,53 @@ RF24 radio(9, 10);  // Set CE and CSN pins
 
 // Input handler and channel array
 InputHandler inputHandler;
-Channel channels[10];
-
-// The sizeof this struct should not exceed 32 bytes
-struct ChannelValues {
-    byte ch1;
-    byte ch2;
-    byte ch3;
-    byte ch4;
-    byte ch5;
-    byte ch6;
-    byte ch7;
-    byte ch8;
-    byte ch9;
-    byte ch10;
+Channel channels[MAX_CHANNELS];
+DigitalInputs digitalInputs;
+#ifdef RC_TRACE
+InputTrace inputTrace;
+#endif
+
+// External input backends, started when a channel first uses them
+#ifdef SIMULATED_INPUTS
+SimulatedAdc externalAdc;
+SimulatedSwitchBank switchBank;
+#else
+ExternalAdc externalAdc;
+SwitchBank switchBank;
+#endif
+InputBackend* const inputBackends[] = {&externalAdc, &switchBank};
+Mixer mixer;
+CurveHandler curves;
+
+#ifdef RC_PROFILE
+// Profiled stages (RCProfiler.h) and their budgets in microseconds
+enum ProfileStage : uint8_t {
+    PROFILE_INPUTS,    // updateInputs(): reads, curves and mixer
+    PROFILE_RADIO,     // Radio frame encoding and FIFO load
+    PROFILE_SERIAL,    // Serial byte collection, including any command it completes
+    PROFILE_COMMAND,   // One config panel command
+    PROFILE_EEPROM,    // Model slot writes
+    PROFILE_FRAME,     // Whole frame: inputs and radio
+    PROFILE_STAGES
+};
+
+const char profileInputs[] PROGMEM = "inputs";
+const char profileRadio[] PROGMEM = "radio";
+const char profileSerial[] PROGMEM = "serial";
+const char profileCommand[] PROGMEM = "command";
+const char profileEeprom[] PROGMEM = "eeprom";
+const char profileFrame[] PROGMEM = "frame";
+const char* const profileNames[PROFILE_STAGES] PROGMEM = {
+    profileInputs, profileRadio, profileSerial, profileCommand, profileEeprom, profileFrame
+};
+const uint16_t profileBudgets[PROFILE_STAGES] PROGMEM = {
+    2500, 250, 1000, 2000, PROFILE_NO_BUDGET, 5000  // Radio only loads the FIFO, frame = FRAME_PERIOD_US
 };
 
+ProfileStats profileStats[PROFILE_STAGES];
+Profiler profiler(profileStats, PROFILE_STAGES, profileNames, profileBudgets);
+#endif
+
 // Create a variable with the structure above and name it sent_data
 ChannelValues channelValues;
 
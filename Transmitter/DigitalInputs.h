@@ -0,0 +1,123 @@
+#ifndef DIGITAL_INPUTS_H
+#define DIGITAL_INPUTS_H
+
+#include <Arduino.h>
+#include "InputTrace.h"
+
+// Debounce depth: a pin must integrate this many frames towards a new level before the
+// debounced state follows it (5 ms frames, so 4 = 20 ms). 1 disables debouncing.
+const uint8_t DEBOUNCE_SAMPLES = 4;
+
+// GPIO ports of the ATmega328P: D0-D7 = PIND, D8-D13 = PINB, A0-A5 = PINC
+const uint8_t DIGITAL_PORTS = 3;
+
+// DigitalInputs Class
+//
+// Snapshots every input port once per frame, so all digital and three-state channels
+// decode from the same sample instant and no channel pays for digitalRead's pin lookup.
+// Each pin runs an up/down integrator; only pins that differ from their debounced state
+// or are still integrating are visited, a quiet port costs one compare.
+class DigitalInputs {
+public:
+    DigitalInputs() {
+        memset(state, 0, sizeof(state));
+        memset(pending, 0, sizeof(pending));
+        memset(counters, 0, sizeof(counters));
+    }
+
+    // Take the current pin levels as settled (call once the pin modes are configured)
+    void begin() {
+        readPorts(state);
+        for (uint8_t port = 0; port < DIGITAL_PORTS; ++port) {
+            pending[port] = 0;
+            for (uint8_t bit = 0; bit < 8; ++bit) {
+                counters[port][bit] = (state[port] & _BV(bit)) ? DEBOUNCE_SAMPLES : 0;
+            }
+        }
+    }
+
+    // Sample all ports, once per frame before the channels are read
+    void sample() {
+        uint8_t raw[DIGITAL_PORTS];
+        readPorts(raw);
+        for (uint8_t port = 0; port < DIGITAL_PORTS; ++port) {
+            if (DEBOUNCE_SAMPLES <= 1) {
+                state[port] = raw[port];
+            } else if ((raw[port] ^ state[port]) | pending[port]) {
+                integrate(port, raw[port]);
+            }
+        }
+    }
+
+    // Debounced level of a pin fixed at compile time
+    template<uint8_t PIN>
+    bool read() const {
+        static_assert(PIN < A6, "Pin has no digital input");
+        return state[portOf(PIN)] & _BV(bitOf(PIN));
+    }
+
+    // Debounced level of a pin known only at runtime (A6/A7 have no digital input)
+    bool read(uint8_t pin) const {
+        if (pin >= A6) return false;
+        return state[portOf(pin)] & _BV(bitOf(pin));
+    }
+
+private:
+    uint8_t state[DIGITAL_PORTS];     // Debounced levels
+    uint8_t pending[DIGITAL_PORTS];   // Pins whose integrator is between the rails
+    uint8_t counters[DIGITAL_PORTS][8];
+
+    static constexpr uint8_t portOf(uint8_t pin) {
+        return pin < 8 ? 0 : (pin < 14 ? 1 : 2);
+    }
+
+    static constexpr uint8_t bitOf(uint8_t pin) {
+        return pin < 8 ? pin : (pin < 14 ? pin - 8 : pin - 14);
+    }
+
+    // The three reads are back to back, a few cycles apart
+    static void readPorts(uint8_t* levels) {
+#ifdef RC_TRACE
+        if (inputTrace.replaying()) {
+            memcpy(levels, inputTrace.sample.ports, DIGITAL_PORTS);
+            return;
+        }
+#endif
+        levels[0] = PIND;
+        levels[1] = PINB;
+        levels[2] = PINC;
+#ifdef RC_TRACE
+        memcpy(inputTrace.sample.ports, levels, DIGITAL_PORTS);
+#endif
+    }
+
+    void integrate(uint8_t port, uint8_t raw) {
+        uint8_t active = (raw ^ state[port]) | pending[port];
+        for (uint8_t bit = 0; bit < 8; ++bit) {
+            uint8_t mask = _BV(bit);
+            if (!(active & mask)) continue;
+
+            uint8_t& counter = counters[port][bit];
+            if (raw & mask) {
+                if (counter < DEBOUNCE_SAMPLES) counter++;
+            } else {
+                if (counter > 0) counter--;
+            }
+
+            if (counter == DEBOUNCE_SAMPLES) {
+                state[port] |= mask;
+                pending[port] &= ~mask;
+            } else if (counter == 0) {
+                state[port] &= ~mask;
+                pending[port] &= ~mask;
+            } else {
+                pending[port] |= mask;
+            }
+        }
+    }
+};
+
+// Shared by every channel, defined in DataDefinitions.h
+extern DigitalInputs digitalInputs;
+
+#endif
@@ -0,0 +1,263 @@
+#ifndef INPUT_BACKENDS_H
+#define INPUT_BACKENDS_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "InputTrace.h"
+
+// Time kept free before each frame: backends only start a bus transaction when the
+// next frame is further away than this, so they never delay a frame
+const unsigned long BACKEND_GUARD_US = 500;
+
+// InputBackend Class
+//
+// A source of channel inputs that is not an on-chip pin. Backends are polled from the
+// main loop between frames; each poll() runs at most one short bus transaction and the
+// results are cached, so a channel read is just a RAM lookup.
+class InputBackend {
+public:
+    // Claim the bus pins, called for every channel assigned to the backend
+    void begin() {
+        assigned = true;
+        if (!started) {
+            started = true;
+            start();
+        }
+    }
+
+    // Channel configs are being reloaded, the backend stays in use only if a channel is
+    // assigned to it again
+    void unassign() {
+        assigned = false;
+    }
+
+    // After a reload: stop a backend no channel uses any more, and put back the bus pin
+    // modes of one in use (a channel that used to be on those pins may have changed them)
+    void settle() {
+        if (!started) return;
+        if (!assigned) {
+            started = false;
+            stop();
+        } else {
+            claimPins();
+        }
+    }
+
+    // Advance the backend's transfer schedule, only while it is in use
+    void poll(unsigned long now) {
+        if (started) service(now);
+    }
+
+    // Latest value of one input: 0-1023 for analog inputs, 0 or 1 for switches
+    virtual uint16_t read(uint8_t index) const = 0;
+
+protected:
+    bool started = false;
+    bool assigned = false;
+
+    virtual void start() = 0;
+    virtual void service(unsigned long now) = 0;
+    virtual void claimPins() {}
+    virtual void stop() {}
+};
+
+// ADS1115-class 16-bit I2C ADC, 4 single-ended inputs
+//
+// Conversions are single-shot at 860 SPS, one input at a time: one poll() writes the
+// config register to start a conversion, a later poll() (once it is done) reads the
+// result. Each transaction is ~100 us at 400 kHz. Uses the hardware I2C pins A4/A5, so
+// joysticks J1/J2 cannot be used together with external ADC inputs.
+const uint8_t EXTERNAL_ADC_ADDRESS = 0x48;      // ADDR pin to GND
+const uint8_t EXTERNAL_ADC_INPUTS = 4;
+const unsigned long EXTERNAL_ADC_CONVERSION_US = 1300;  // 1/860 s plus margin
+const unsigned long EXTERNAL_ADC_RETRY_MS = 1000;       // After a bus error
+const uint16_t EXTERNAL_ADC_FULL_SCALE = 26667;         // Counts at 5 V, 187.5 uV each at this gain
+
+class ExternalAdc : public InputBackend {
+public:
+    uint16_t read(uint8_t index) const override {
+        if (index >= EXTERNAL_ADC_INPUTS) return 0;
+#ifdef RC_TRACE
+        if (inputTrace.replaying()) return inputTrace.sample.adc[index];
+        inputTrace.sample.adc[index] = values[index];
+#endif
+        return values[index];
+    }
+
+protected:
+    void start() override {
+        Wire.begin();
+        Wire.setClock(400000);
+        Wire.setWireTimeout(1000, true);  // A missing or stuck device must not hang the transmitter
+        converting = false;
+        input = 0;
+        memset(values, 0, sizeof(values));
+    }
+
+    // The TWI drives the pins itself, only the pull-ups Wire.begin() set can be lost
+    void claimPins() override {
+        digitalWrite(SDA, HIGH);
+        digitalWrite(SCL, HIGH);
+    }
+
+    // Hand A4/A5 back to analog inputs
+    void stop() override {
+        Wire.end();
+    }
+
+    void service(unsigned long now) override {
+        if (failed) {
+            if (millis() - failTime < EXTERNAL_ADC_RETRY_MS) return;
+            failed = false;
+        }
+
+        if (!converting) {
+            // OS = start, MUX = AINx vs GND, PGA = +-6.144 V, single-shot, 860 SPS, no comparator
+            uint16_t configValue = 0x8000 | ((uint16_t)(4 + input) << 12) | 0x0100 | 0x00E0 | 0x0003;
+            Wire.beginTransmission(EXTERNAL_ADC_ADDRESS);
+            Wire.write(0x01);  // Config register
+            Wire.write(highByte(configValue));
+            Wire.write(lowByte(configValue));
+            if (Wire.endTransmission() != 0) {
+                fail();
+                return;
+            }
+            converting = true;
+            conversionStart = now;
+        } else if (now - conversionStart >= EXTERNAL_ADC_CONVERSION_US) {
+            Wire.beginTransmission(EXTERNAL_ADC_ADDRESS);
+            Wire.write(0x00);  // Conversion register
+            if (Wire.endTransmission() != 0 || Wire.requestFrom(EXTERNAL_ADC_ADDRESS, (uint8_t)2) != 2) {
+                fail();
+                return;
+            }
+            int16_t raw = (Wire.read() << 8) | Wire.read();
+
+            // Scale 0-5 V to analogRead's 0-1023, once per conversion so the division is affordable
+            values[input] = min((uint32_t)max(raw, (int16_t)0) * 1023 / EXTERNAL_ADC_FULL_SCALE, 1023UL);
+            converting = false;
+            input = (input + 1) % EXTERNAL_ADC_INPUTS;
+        }
+    }
+
+private:
+    uint16_t values[EXTERNAL_ADC_INPUTS];
+    uint8_t input = 0;             // Input being converted
+    bool converting = false;
+    unsigned long conversionStart = 0;
+    bool failed = false;
+    unsigned long failTime = 0;
+
+    void fail() {
+        failed = true;
+        failTime = millis();
+        converting = false;
+    }
+};
+
+// 74HC165 shift-register switch bank
+//
+// All switches are latched at the same instant and shifted in with direct port access
+// (a few microseconds per byte), once per frame period. The bank shares pins 6/7/8 with
+// the digital inputs D1-D3, which cannot be used together with bank switches.
+const uint8_t SWITCH_BANK_LATCH_PIN = 6;   // SH/LD
+const uint8_t SWITCH_BANK_CLOCK_PIN = 7;   // CLK
+const uint8_t SWITCH_BANK_DATA_PIN = 8;    // QH
+const uint8_t SWITCH_BANK_BYTES = 1;       // Chained 74HC165s
+const unsigned long SWITCH_BANK_PERIOD_US = 5000;
+
+#ifdef RC_TRACE
+static_assert(EXTERNAL_ADC_INPUTS == TRACE_ADC_INPUTS && SWITCH_BANK_BYTES == 1,
+              "Input traces record 4 ADC inputs and one switch bank byte");
+#endif
+
+class SwitchBank : public InputBackend {
+public:
+    // Switches pull their input low when closed, so a closed switch reads 1
+    uint16_t read(uint8_t index) const override {
+        if (index >= SWITCH_BANK_BYTES * 8) return 0;
+#ifdef RC_TRACE
+        if (inputTrace.replaying()) return !(inputTrace.sample.bank & _BV(7 - index));
+        inputTrace.sample.bank = bits[0];
+#endif
+        return !(bits[index >> 3] & _BV(7 - (index & 7)));
+    }
+
+protected:
+    void start() override {
+        claimPins();
+        latchPort = portOutputRegister(digitalPinToPort(SWITCH_BANK_LATCH_PIN));
+        latchMask = digitalPinToBitMask(SWITCH_BANK_LATCH_PIN);
+        clockPort = portOutputRegister(digitalPinToPort(SWITCH_BANK_CLOCK_PIN));
+        clockMask = digitalPinToBitMask(SWITCH_BANK_CLOCK_PIN);
+        dataPort = portInputRegister(digitalPinToPort(SWITCH_BANK_DATA_PIN));
+        dataMask = digitalPinToBitMask(SWITCH_BANK_DATA_PIN);
+        memset(bits, 0xFF, sizeof(bits));  // All open
+    }
+
+    void claimPins() override {
+        pinMode(SWITCH_BANK_LATCH_PIN, OUTPUT);
+        pinMode(SWITCH_BANK_CLOCK_PIN, OUTPUT);
+        pinMode(SWITCH_BANK_DATA_PIN, INPUT);
+        digitalWrite(SWITCH_BANK_LATCH_PIN, HIGH);
+        digitalWrite(SWITCH_BANK_CLOCK_PIN, LOW);
+    }
+
+    void service(unsigned long now) override {
+        if (now - lastShift < SWITCH_BANK_PERIOD_US) return;
+        lastShift = now;
+
+        // Parallel load, then shift out MSB (input H) first
+        *latchPort &= ~latchMask;
+        *latchPort |= latchMask;
+        for (uint8_t b = 0; b < SWITCH_BANK_BYTES; ++b) {
+            uint8_t value = 0;
+            for (uint8_t bit = 0; bit < 8; ++bit) {
+                value = (value << 1) | ((*dataPort & dataMask) ? 1 : 0);
+                *clockPort |= clockMask;
+                *clockPort &= ~clockMask;
+            }
+            bits[b] = value;
+        }
+    }
+
+private:
+    uint8_t bits[SWITCH_BANK_BYTES];
+    unsigned long lastShift = 0;
+    volatile uint8_t* latchPort;
+    volatile uint8_t* clockPort;
+    volatile uint8_t* dataPort;
+    uint8_t latchMask, clockMask, dataMask;
+};
+
+#ifdef SIMULATED_INPUTS
+// Stand-ins for testing without the external hardware fitted (build with
+// SIMULATED_INPUTS defined): every ADC input sweeps up and down at its own rate and
+// every bank switch toggles at its own rate.
+class SimulatedAdc : public InputBackend {
+public:
+    uint16_t read(uint8_t index) const override {
+        if (index >= EXTERNAL_ADC_INPUTS) return 0;
+        uint16_t phase = (millis() >> (2 + index)) & 0x7FF;  // 0-2047
+        return phase < 1024 ? phase : 2047 - phase;
+    }
+
+protected:
+    void start() override {}
+    void service(unsigned long now) override {}
+};
+
+class SimulatedSwitchBank : public InputBackend {
+public:
+    uint16_t read(uint8_t index) const override {
+        if (index >= SWITCH_BANK_BYTES * 8) return 0;
+        return (millis() >> (9 + index)) & 1;
+    }
+
+protected:
+    void start() override {}
+    void service(unsigned long now) override {}
+};
+#endif
+
+#endif
@@ -2,12 +2,12 @@
 #define INPUT_HANDLER_H
 
 #include <EEPROM.h>
+#include <RCLink.h>
+#include <RCFrame.h>
 
 // Max channels and constants
-const int MAX_CHANNELS = 10;
-const int CHANNEL_BLOCK_SIZE = 100;
-const int EEPROM_START_ADDRESS = 0;
-const uint8_t CONFIG_VERSION = 2; // Increment this when structure changes
+const int MAX_CHANNELS = RC_CHANNEL_COUNT;
+const uint8_t CONFIG_VERSION = 3; // Increment this when structure changes
 
 // Device types
 enum DeviceType : uint8_t {
@@ -15,10 +15,15 @@ enum DeviceType : uint8_t {
     ANALOG_INPUT = 'A',
     THREE_STATE_SWITCH = 'S',
     DIGITAL_INPUT = 'D',
+    EXTERNAL_ANALOG = 'E',   // Input of the external I2C ADC
+    BANK_SWITCH = 'B',       // Switch on the shift-register bank
     INVALID = 0xFF  // To handle invalid device types
 };
 
-// Predefined device mappings
+const char NO_BACKEND = 0;   // pinBackend() of devices that share no pins with a backend
+
+// Predefined device mappings, external devices ('E', 'B') give their input index on the
+// backend as primaryPin
 struct PredefinedDevice {
     char type;
     uint8_t id;
@@ -30,49 +35,108 @@ const PredefinedDevice predefinedDevices[] = {
     {'J', 1, A4, -1}, {'J', 2, A5, -1}, {'J', 3, A6, -1}, {'J', 4, A7, -1},
     {'A', 1, A0, -1}, {'A', 2, A1, -1}, {'A', 3, A2, -1}, {'A', 4, A3, -1},
     {'S', 1, 2, 3}, {'S', 2, 4, 5},
-    {'D', 1, 6, -1}, {'D', 2, 7, -1}, {'D', 3, 8, -1}
+    {'D', 1, 6, -1}, {'D', 2, 7, -1}, {'D', 3, 8, -1},
+    {'E', 1, 0, -1}, {'E', 2, 1, -1}, {'E', 3, 2, -1}, {'E', 4, 3, -1},
+    {'B', 1, 0, -1}, {'B', 2, 1, -1}, {'B', 3, 2, -1}, {'B', 4, 3, -1},
+    {'B', 5, 4, -1}, {'B', 6, 5, -1}, {'B', 7, 6, -1}, {'B', 8, 7, -1}
 };
 
-// Channel configuration structure
-struct ChannelConfig {
-    uint8_t version;       // Configuration version
-    char deviceType;       // Device type ('J', 'A', 'S', 'D')
-    uint8_t deviceId;      // Device ID
-    bool reverse;          // Channel reversing
-    int8_t trim;              // Trim adjustment
-    int analogReadMin;     // Minimum analog read value
-    int analogReadMax;     // Maximum analog read value
-    uint8_t minEndpoint;       // Minimum endpoint
-    uint8_t maxEndpoint;       // Maximum endpoint
-    uint8_t centerPoint;       // Center point adjustment
-};
+// Channel configuration structure: ChannelConfig from the shared schema (RCLink.h), stored
+// in the model's EEPROM slot and sent to the config panel as is
 
 // InputHandler Class
 class InputHandler {
 public:
     ChannelConfig channels[MAX_CHANNELS];
-
-    // Load from EEPROM with validation
-    void loadFromEEPROM() {
+    uint8_t failsafe[MAX_CHANNELS];   // Values sent until the inputs have been read
+    uint8_t rateClass[MAX_CHANNELS];  // RateClass of each channel on the radio (RCFrame.h)
+    uint8_t keyframeInterval;         // Delta mode keyframe every this many frames, DELTA_MODE_OFF
+
+    // Config generations: the global counter increases on every change and each channel
+    // records the global value of its last change, so the config panel can tell which
+    // cached configs are stale. The counter starts at a random value on every boot so a
+    // restarted transmitter never matches a stale cache.
+    uint16_t globalGeneration;
+    uint16_t generation[MAX_CHANNELS];
+
+    void initGenerations(uint16_t seed) {
+        globalGeneration = seed;
         for (int i = 0; i < MAX_CHANNELS; ++i) {
-            int address = EEPROM_START_ADDRESS + i * CHANNEL_BLOCK_SIZE;
-            ChannelConfig tempConfig;
-            EEPROM.get(address, tempConfig);
+            generation[i] = globalGeneration;
+        }
+    }
+
+    // Record a change of one channel's config
+    void markChanged(int index) {
+        if (index < 0 || index >= MAX_CHANNELS) return;
+        generation[index] = ++globalGeneration;
+    }
 
+    // Check the channel configs just read from EEPROM, resetting any that are invalid
+    void validate() {
+        for (int i = 0; i < MAX_CHANNELS; ++i) {
             // Validate version and device type
-            if (tempConfig.version != CONFIG_VERSION || !isValidDeviceType(tempConfig.deviceType)) {
+            if (channels[i].version != CONFIG_VERSION || !isValidDeviceType(channels[i].deviceType)) {
                 initializeChannel(i, INVALID, 0); // Reset to default
-            } else {
-                channels[i] = tempConfig;
+            }
+            if (rateClass[i] >= RATE_CLASSES) {
+                rateClass[i] = defaultRateClass(i);
             }
         }
+        for (int i = 0; i < MAX_CHANNELS; ++i) {
+            if (sharesBackendPins(i) && pinBackend(channels[i].deviceType, channels[i].deviceId) != NO_BACKEND) {
+                initializeChannel(i, INVALID, 0); // The backend keeps its pins
+            }
+        }
+    }
+
+    // Backend whose bus pins a pin device uses: D1-D3 are the switch bank's latch, clock
+    // and data lines, J1/J2 (A4/A5) the external ADC's I2C bus
+    static char pinBackend(char deviceType, uint8_t deviceId) {
+        if (deviceType == DIGITAL_INPUT && deviceId >= 1 && deviceId <= 3) return BANK_SWITCH;
+        if (deviceType == JOYSTICK && (deviceId == 1 || deviceId == 2)) return EXTERNAL_ANALOG;
+        return NO_BACKEND;
+    }
+
+    // Does a channel use pins of a backend another channel uses, or a backend whose pins
+    // another channel uses?
+    bool sharesBackendPins(int index) const {
+        const ChannelConfig& config = channels[index];
+        char ownBackend = pinBackend(config.deviceType, config.deviceId);
+        for (int i = 0; i < MAX_CHANNELS; ++i) {
+            if (i == index) continue;
+            if (ownBackend != NO_BACKEND && channels[i].deviceType == ownBackend) return true;
+            if (pinBackend(channels[i].deviceType, channels[i].deviceId) == config.deviceType) return true;
+        }
+        return false;
+    }
+
+    // Save to EEPROM (only bytes that changed are written)
+    void saveToEEPROM(int address) {
+        EEPROM.put(address, channels);
+    }
+
+    // Reset every channel to defaults
+    void reset() {
+        for (int i = 0; i < MAX_CHANNELS; ++i) {
+            initializeChannel(i, INVALID, 0);
+        }
+        resetFailsafes();
+        for (int i = 0; i < MAX_CHANNELS; ++i) {
+            rateClass[i] = defaultRateClass(i);
+        }
+        keyframeInterval = DELTA_MODE_OFF;
+    }
+
+    // The four sticks every frame, switches and aux inputs when they change
+    static uint8_t defaultRateClass(int index) {
+        return index < 4 ? RATE_EVERY_FRAME : RATE_ON_CHANGE;
     }
 
-    // Save to EEPROM
-    void saveToEEPROM() {
+    // Throttle (channel 1) low, sticks centered, the rest low, same as the receiver's
+    void resetFailsafes() {
         for (int i = 0; i < MAX_CHANNELS; ++i) {
-            int address = EEPROM_START_ADDRESS + i * CHANNEL_BLOCK_SIZE;
-            EEPROM.put(address, channels[i]);
+            failsafe[i] = (i >= 1 && i <= 4) ? 127 : 0;
         }
     }
 
@@ -97,7 +161,8 @@ public:
     // Validate device type
     bool isValidDeviceType(char deviceType) {
         return deviceType == JOYSTICK || deviceType == ANALOG_INPUT ||
-               deviceType == THREE_STATE_SWITCH || deviceType == DIGITAL_INPUT;
+               deviceType == THREE_STATE_SWITCH || deviceType == DIGITAL_INPUT ||
+               deviceType == EXTERNAL_ANALOG || deviceType == BANK_SWITCH;
     }
 
     // Get predefined device mapping
@@ -0,0 +1,188 @@
+#ifndef INPUT_TRACE_H
+#define INPUT_TRACE_H
+
+#include <Arduino.h>
+#include <RCLink.h>
+
+// Input trace record and replay, built only with RC_TRACE defined (tools/trace.py).
+//
+// Recording ("OR") streams every frame's raw sources over the serial port: the analog
+// pins the readers sampled, the undebounced port levels and the external backend
+// inputs, followed by the frame that was sent. Replay ("OP") takes the same records from
+// the host instead of the hardware and answers each with the frame the pipeline
+// (debounce, readers, curves, mixer) computed from it, as fast as the link delivers
+// them. Nothing is sent over the radio while replaying.
+//
+// Records, little-endian: sync byte, type, uint16 microseconds since the previous record
+// (saturating), payload.
+//   'I' inputs: uint16 mask of the sources that changed since the last 'I' record, then
+//       those sources in bit order: bits 0-7 analog A0-A7 (uint16), 8-10 PIND/PINB/PINC,
+//       11-14 external ADC inputs (uint16), 15 switch bank byte
+//   'F' frame: the ChannelValues sent
+//   'E' end of replay (host to transmitter, no payload)
+// The first 'I' record of a recording has every bit set. Recording needs a serial rate
+// of 250000 or more to keep up with the 5 ms frames.
+
+#ifdef RC_TRACE
+
+const uint8_t TRACE_SYNC = 0xA5;
+const uint8_t TRACE_ANALOG_PINS = 8;
+const uint8_t TRACE_PORTS = 3;
+const uint8_t TRACE_ADC_INPUTS = 4;
+
+const uint8_t TRACE_PORT_BIT = 8;
+const uint8_t TRACE_ADC_BIT = 11;
+const uint8_t TRACE_BANK_BIT = 15;
+
+// Raw input sources of one frame
+struct TraceSample {
+    uint16_t analog[TRACE_ANALOG_PINS];
+    uint8_t ports[TRACE_PORTS];
+    uint16_t adc[TRACE_ADC_INPUTS];
+    uint8_t bank;
+};
+
+class InputTrace {
+public:
+    enum Mode : uint8_t {
+        TRACE_OFF,
+        TRACE_RECORD,
+        TRACE_REPLAY
+    };
+
+    // What feed() made of a byte
+    enum FeedResult : uint8_t {
+        TRACE_PENDING,   // Record incomplete
+        TRACE_SAMPLE,    // A new sample is loaded, compute a frame
+        TRACE_END        // The host ended the replay
+    };
+
+    Mode mode;
+    TraceSample sample;   // This frame's sources: captured while recording, injected while replaying
+
+    InputTrace() : mode(TRACE_OFF), lastRecord(0), keyframe(true), restart(false), received(0) {
+        memset(&sample, 0, sizeof(sample));
+        memset(&previous, 0, sizeof(previous));
+    }
+
+    bool replaying() const { return mode == TRACE_REPLAY; }
+    bool recording() const { return mode == TRACE_RECORD; }
+
+    void start(Mode m) {
+        mode = m;
+        keyframe = true;
+        restart = m != TRACE_OFF;
+        received = 0;
+        lastRecord = micros();
+    }
+
+    // True once for the first frame of a recording or replay: the debouncer restarts from
+    // that frame's levels, so both see the same debounce history
+    bool takeRestart() {
+        bool first = restart;
+        restart = false;
+        return first;
+    }
+
+    // Stream this frame's sources and the frame built from them
+    void record(Print& out, const ChannelValues& frame) {
+        uint16_t mask = keyframe ? 0xFFFF : changedSources();
+        keyframe = false;
+
+        writeHeader(out, 'I');
+        out.write((const uint8_t*)&mask, sizeof(mask));
+        for (uint8_t bit = 0; bit < 16; ++bit) {
+            if (mask & (1u << bit)) {
+                out.write(field(sample, bit), fieldSize(bit));
+            }
+        }
+        previous = sample;
+
+        sendFrame(out, frame);
+    }
+
+    // Answer a replayed sample
+    void sendFrame(Print& out, const ChannelValues& frame) {
+        writeHeader(out, 'F');
+        out.write((const uint8_t*)&frame, sizeof(frame));
+    }
+
+    // Collect one byte of a replayed record
+    FeedResult feed(uint8_t byte) {
+        if (received == 0 && byte != TRACE_SYNC) return TRACE_PENDING;  // Resynchronize
+        buffer[received++] = byte;
+
+        if (received == 2 && buffer[1] != 'I' && buffer[1] != 'E') {
+            received = 0;  // Frames and unknown records are not replayed
+            return TRACE_PENDING;
+        }
+        if (received < 4) return TRACE_PENDING;
+        if (buffer[1] == 'E') {
+            received = 0;
+            return TRACE_END;
+        }
+        if (received < 6) return TRACE_PENDING;
+
+        uint16_t mask = buffer[4] | (buffer[5] << 8);
+        uint8_t length = 6;
+        for (uint8_t bit = 0; bit < 16; ++bit) {
+            if (mask & (1u << bit)) length += fieldSize(bit);
+        }
+        if (received < length) return TRACE_PENDING;
+
+        const uint8_t* data = buffer + 6;
+        for (uint8_t bit = 0; bit < 16; ++bit) {
+            if (mask & (1u << bit)) {
+                memcpy(field(sample, bit), data, fieldSize(bit));
+                data += fieldSize(bit);
+            }
+        }
+        received = 0;
+        return TRACE_SAMPLE;
+    }
+
+private:
+    TraceSample previous;          // Last recorded sample, for the change mask
+    unsigned long lastRecord;
+    bool keyframe;
+    bool restart;
+    uint8_t buffer[6 + sizeof(TraceSample)];
+    uint8_t received;
+
+    static uint8_t fieldSize(uint8_t bit) {
+        return (bit < TRACE_PORT_BIT || (bit >= TRACE_ADC_BIT && bit < TRACE_BANK_BIT)) ? 2 : 1;
+    }
+
+    static uint8_t* field(TraceSample& s, uint8_t bit) {
+        if (bit < TRACE_PORT_BIT) return (uint8_t*)&s.analog[bit];
+        if (bit < TRACE_ADC_BIT) return &s.ports[bit - TRACE_PORT_BIT];
+        if (bit < TRACE_BANK_BIT) return (uint8_t*)&s.adc[bit - TRACE_ADC_BIT];
+        return &s.bank;
+    }
+
+    uint16_t changedSources() {
+        uint16_t mask = 0;
+        for (uint8_t bit = 0; bit < 16; ++bit) {
+            if (memcmp(field(sample, bit), field(previous, bit), fieldSize(bit)) != 0) {
+                mask |= 1u << bit;
+            }
+        }
+        return mask;
+    }
+
+    void writeHeader(Print& out, char type) {
+        unsigned long now = micros();
+        uint16_t elapsed = min(now - lastRecord, 0xFFFFUL);
+        lastRecord = now;
+        out.write(TRACE_SYNC);
+        out.write((uint8_t)type);
+        out.write((const uint8_t*)&elapsed, sizeof(elapsed));
+    }
+};
+
+// Defined in DataDefinitions.h
+extern InputTrace inputTrace;
+
+#endif // RC_TRACE
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef LATENCY_LOOPBACK_H
+#define LATENCY_LOOPBACK_H
+
+#ifdef RC_LATENCY
+
+#include <RCLatency.h>
+
+// Round-trip latency test ("SL<channel>", RC_LATENCY builds). The stimulus pin is wired to
+// the on-chip input of the channel under test and that channel's servo output on the
+// receiver is wired back to the return pin. The stimulus toggles periodically; the result
+// is the time from the toggle to the rising edge of the first servo pulse whose width
+// shows the new level, the opposite one for a reversed channel. Both pins are the S2
+// switch's, which cannot be used during the test and is set up again by "SX".
+const uint8_t LOOPBACK_STIMULUS_PIN = 4;
+const uint8_t LOOPBACK_RETURN_PIN = 5;          // PD5 = PCINT21
+const unsigned long LOOPBACK_PERIOD_MS = 250;   // Longer than any round trip
+const uint16_t LOOPBACK_MID_US = 1500;          // Pulse width between the two levels
+
+class LatencyLoopback {
+public:
+    LatencyStats stats;
+
+    LatencyLoopback()
+        : stats(1000), running(false), channel(0), level(false), expectHigh(false), waiting(false),
+          resultReady(false) {}
+
+    // A channel the stimulus can drive: read from an on-chip pin other than the test's
+    static bool canTest(int index) {
+        if (index < 0 || index >= MAX_CHANNELS) return false;
+        const ChannelConfig& config = inputHandler.channels[index];
+        const PredefinedDevice* device = inputHandler.getPredefinedDevice(config.deviceType, config.deviceId);
+        if (device == nullptr || config.deviceType == EXTERNAL_ANALOG || config.deviceType == BANK_SWITCH) return false;
+        return device->primaryPin != LOOPBACK_STIMULUS_PIN && device->primaryPin != LOOPBACK_RETURN_PIN &&
+               device->secondaryPin != LOOPBACK_STIMULUS_PIN && device->secondaryPin != LOOPBACK_RETURN_PIN;
+    }
+
+    void begin(uint8_t testChannel) {
+        channel = testChannel;
+        pinMode(LOOPBACK_STIMULUS_PIN, OUTPUT);
+        digitalWrite(LOOPBACK_STIMULUS_PIN, LOW);
+        pinMode(LOOPBACK_RETURN_PIN, INPUT);
+        PCMSK2 |= _BV(PCINT21);
+        PCICR |= _BV(PCIE2);
+        stats.reset();
+        level = false;
+        lastToggle = millis();
+        waiting = false;
+        running = true;
+    }
+
+    // Release both pins, the caller hands them back to the S2 switch
+    void end() {
+        noInterrupts();
+        PCMSK2 &= ~_BV(PCINT21);
+        running = false;
+        waiting = false;
+        interrupts();
+        pinMode(LOOPBACK_STIMULUS_PIN, INPUT);
+    }
+
+    bool isRunning() const { return running; }
+
+    // From the main loop: collect the last result and toggle the stimulus when due
+    void service() {
+        if (!running) return;
+
+        if (resultReady) {
+            noInterrupts();
+            uint32_t latency = result;
+            resultReady = false;
+            interrupts();
+            stats.add(latency);
+        }
+
+        if (millis() - lastToggle >= LOOPBACK_PERIOD_MS) {
+            lastToggle = millis();
+            level = !level;
+            // Read on every toggle, reversing the channel mid-test takes effect at once
+            bool high = level != inputHandler.channels[channel].reverse;
+            noInterrupts();
+            expectHigh = high;
+            digitalWrite(LOOPBACK_STIMULUS_PIN, level);
+            stimulusMicros = micros();
+            waiting = true;
+            interrupts();
+        }
+    }
+
+    // Pin change on the return pin, from the interrupt
+    void onEdge() {
+        unsigned long now = micros();
+        if (PIND & _BV(LOOPBACK_RETURN_PIN)) {
+            riseMicros = now;
+            return;
+        }
+        if (!waiting || (long)(riseMicros - stimulusMicros) < 0) return;  // Pulse started before the toggle
+
+        bool high = now - riseMicros > LOOPBACK_MID_US;
+        if (high == expectHigh) {
+            result = riseMicros - stimulusMicros;
+            resultReady = true;
+            waiting = false;
+        }
+    }
+
+private:
+    bool running;
+    uint8_t channel;                  // Channel under test
+    bool level;                       // Current stimulus level
+    volatile bool expectHigh;         // Pulse level that shows the current stimulus level
+    unsigned long lastToggle;
+    volatile bool waiting;            // A toggle has not come back yet
+    volatile bool resultReady;
+    volatile uint32_t result;
+    volatile unsigned long stimulusMicros;
+    volatile unsigned long riseMicros;
+};
+
+LatencyLoopback latencyLoopback;
+
+ISR(PCINT2_vect) {
+    latencyLoopback.onEdge();
+}
+
+#endif // RC_LATENCY
+
+#endif
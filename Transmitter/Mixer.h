@@ -0,0 +1,169 @@
+#ifndef MIXER_H
+#define MIXER_H
+
+#include <Arduino.h>
+#include <EEPROM.h>
+
+// Mixer limits and storage
+const int MAX_MIXES = 16;
+const int MAX_MIX_CURVES = 4;
+const int MIX_CURVE_POINTS = 5;           // Outputs at -100%, -50%, 0%, +50%, +100% input
+const uint8_t MIXER_VERSION = 1;          // Increment this when structure changes
+
+const uint8_t MIX_UNUSED = 0xFF;          // Source of an empty rule slot
+
+// Destinations are tracked in a 16-bit mask
+static_assert(MAX_CHANNELS <= 16, "Mixer supports at most 16 channels");
+
+enum MixMode : uint8_t {
+    MIX_ADD = 0,      // Add to the destination
+    MIX_REPLACE = 1   // Overwrite whatever earlier rules put into the destination
+};
+
+// One mix rule: destination (+)= curve(source) * weight + offset
+struct MixRule {
+    uint8_t source;       // Input channel index, MIX_UNUSED for an empty slot
+    uint8_t destination;  // Output channel index
+    int8_t weight;        // Percent, -100 to 100
+    int8_t offset;        // Percent of half range, -100 to 100
+    uint8_t curve;        // 0 = linear, 1..MAX_MIX_CURVES = curves[curve - 1]
+    uint8_t mode;         // MixMode
+};
+
+struct MixerConfig {
+    uint8_t version;
+    MixRule rules[MAX_MIXES];
+    int8_t curves[MAX_MIX_CURVES][MIX_CURVE_POINTS];  // Output percent per curve point
+};
+
+// Mixer Class
+//
+// Runs between input reading and frame encoding. Values are centered to -128..127 and
+// evaluated in 16-bit fixed point: percents become Q7 factors (100% = 128), every rule
+// contributes at most +-256, so 16 rules cannot overflow and one saturation at the end
+// is enough. Outputs without any rule pass their input through unchanged.
+class Mixer {
+public:
+    MixerConfig config;
+    uint16_t lastMicros;   // Duration of the last apply()
+    uint16_t maxMicros;    // Longest apply() since boot
+
+    Mixer() : lastMicros(0), maxMicros(0), activeRules(0) {}
+
+    // Check the config just read from EEPROM, dropping rules with out-of-range fields so
+    // apply() never indexes past the channels or the curves
+    void validate(uint8_t channelCount) {
+        if (config.version != MIXER_VERSION) {
+            reset();
+        }
+        for (int i = 0; i < MAX_MIXES; ++i) {
+            if (!isValidRule(config.rules[i], channelCount)) {
+                config.rules[i] = {MIX_UNUSED, 0, 100, 0, 0, MIX_ADD};
+            }
+        }
+        updateActiveRules();
+    }
+
+    // Save to EEPROM
+    void saveToEEPROM(int address) {
+        updateActiveRules();
+        EEPROM.put(address, config);
+    }
+
+    // Remove all rules and make every curve linear
+    void reset() {
+        config.version = MIXER_VERSION;
+        for (int i = 0; i < MAX_MIXES; ++i) {
+            config.rules[i] = {MIX_UNUSED, 0, 100, 0, 0, MIX_ADD};
+        }
+        for (int c = 0; c < MAX_MIX_CURVES; ++c) {
+            for (int p = 0; p < MIX_CURVE_POINTS; ++p) {
+                config.curves[c][p] = -100 + p * 50;
+            }
+        }
+    }
+
+    // Validate and store a rule, false if any field is out of range
+    bool setRule(int index, const MixRule& rule, uint8_t channelCount) {
+        if (index < 0 || index >= MAX_MIXES || !isValidRule(rule, channelCount)) return false;
+        config.rules[index] = rule;
+        return true;
+    }
+
+    // Apply the rules to values (channelCount bytes, 0-255) in place
+    void apply(uint8_t* values, uint8_t channelCount) {
+        if (activeRules == 0) return;
+        unsigned long startTime = micros();
+
+        int16_t inputs[MAX_CHANNELS];   // Sources always see the unmixed values
+        int16_t outputs[MAX_CHANNELS];
+        uint16_t mixed = 0;  // Bit per destination touched by a rule
+        for (uint8_t i = 0; i < channelCount; ++i) {
+            inputs[i] = (int16_t)values[i] - 128;
+        }
+
+        for (uint8_t i = 0; i < activeRules; ++i) {
+            const MixRule& rule = config.rules[i];
+            if (rule.source == MIX_UNUSED) continue;
+
+            int16_t x = inputs[rule.source];
+            if (rule.curve != 0) {
+                x = applyCurve(config.curves[rule.curve - 1], x);
+            }
+            int16_t contribution = (x * toQ7(rule.weight)) >> 7;
+            contribution += toQ7(rule.offset);
+
+            uint16_t bit = 1u << rule.destination;
+            if (rule.mode == MIX_REPLACE || !(mixed & bit)) {
+                outputs[rule.destination] = contribution;
+                mixed |= bit;
+            } else {
+                outputs[rule.destination] += contribution;
+            }
+        }
+
+        for (uint8_t i = 0; i < channelCount; ++i) {
+            if (mixed & (1u << i)) {
+                values[i] = constrain(outputs[i], -128, 127) + 128;
+            }
+        }
+
+        lastMicros = micros() - startTime;
+        if (lastMicros > maxMicros) maxMicros = lastMicros;
+    }
+
+private:
+    uint8_t activeRules;  // Rules up to and including the last used slot
+
+    // An empty slot, or every field in range
+    static bool isValidRule(const MixRule& rule, uint8_t channelCount) {
+        return rule.source == MIX_UNUSED ||
+               (rule.source < channelCount && rule.destination < channelCount &&
+                rule.weight >= -100 && rule.weight <= 100 && rule.offset >= -100 && rule.offset <= 100 &&
+                rule.curve <= MAX_MIX_CURVES && rule.mode <= MIX_REPLACE);
+    }
+
+    void updateActiveRules() {
+        activeRules = 0;
+        for (int i = 0; i < MAX_MIXES; ++i) {
+            if (config.rules[i].source != MIX_UNUSED) activeRules = i + 1;
+        }
+    }
+
+    // Percent (-100..100) to a Q7 factor (-128..128), 41/32 = 1.28
+    static int16_t toQ7(int8_t percent) {
+        return ((int16_t)percent * 41) >> 5;
+    }
+
+    // Piecewise linear curve through 5 points, 64 input steps per segment
+    static int16_t applyCurve(const int8_t* points, int16_t x) {
+        uint8_t shifted = x + 128;            // 0..255
+        uint8_t segment = shifted >> 6;       // 0..3
+        uint8_t fraction = shifted & 0x3F;    // 0..63
+        int16_t y0 = toQ7(points[segment]);
+        int16_t y1 = toQ7(points[segment + 1]);
+        return y0 + (((y1 - y0) * fraction) >> 6);
+    }
+};
+
+#endif
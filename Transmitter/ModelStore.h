@@ -0,0 +1,287 @@
+#ifndef MODEL_STORE_H
+#define MODEL_STORE_H
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <stddef.h>
+#include <util/crc16.h>
+
+// EEPROM layout: a small header, then one packed slot per model
+const int MODEL_HEADER_ADDRESS = 0;
+const int MODEL_SLOTS_ADDRESS = 16;       // Header area, room to grow
+const uint8_t MODEL_STORE_VERSION = 1;    // Increment this when the header changes
+const uint8_t MODEL_VERSION = 4;          // Increment this when ModelImage changes
+
+struct ModelStoreHeader {
+    uint8_t version;
+    uint8_t activeModel;
+};
+
+// Everything that belongs to one model, in EEPROM order. In RAM the parts live in
+// inputHandler, mixer and curves, which together form the active model's image.
+struct ModelImage {
+    uint8_t version;
+    uint16_t crc;                         // CRC-16 of everything below
+    ChannelConfig channels[MAX_CHANNELS];
+    uint8_t failsafe[MAX_CHANNELS];
+    uint8_t rateClass[MAX_CHANNELS];
+    uint8_t keyframeInterval;
+    MixerConfig mixer;
+    CurveConfig curves;
+};
+
+const uint8_t MODEL_SLOTS = (E2END + 1 - MODEL_SLOTS_ADDRESS) / sizeof(ModelImage);
+
+static_assert(MODEL_SLOTS >= 1, "A model does not fit in EEPROM");
+
+// ModelStore Class
+//
+// Owns the EEPROM layout. Loading a model reads its slot straight into the RAM image in
+// one pass, checking the CRC on the way (a slot that fails is reset to defaults), then
+// rebuilds the derived state (channel readers, curve tables). Every save updates the CRC.
+//
+// A model switch or copy only reads: the header and whole slots (one reset to defaults, or
+// the target of a copy) are written in the background by service(), one byte per call
+// once the EEPROM is idle, since writing a whole slot takes about a second (3.3 ms per
+// byte). The slot's version byte is cleared first and written last, so a save cut short
+// by another switch or a power loss leaves a slot that is reset to defaults again on its
+// next use.
+const uint8_t MODEL_NO_SAVE = 0xFF;
+
+class ModelStore {
+public:
+    uint8_t activeModel;
+    uint16_t switchMicros;   // Duration of the last model switch
+
+    ModelStore() : activeModel(0), switchMicros(0), headerPending(false),
+                   saveSlot(MODEL_NO_SAVE), saveOffset(0) {}
+
+    // Read the header and the active model's image. Only the raw image is loaded, so the
+    // failsafe values are usable right away; call prepare() before reading inputs. Nothing
+    // is written here: on a fresh or corrupt EEPROM the repairs go out from the loop, after
+    // the failsafe frame.
+    void begin() {
+        ModelStoreHeader header;
+        EEPROM.get(MODEL_HEADER_ADDRESS, header);
+        if (header.version != MODEL_STORE_VERSION || header.activeModel >= MODEL_SLOTS) {
+            header = {MODEL_STORE_VERSION, 0};
+            headerPending = true;
+        }
+        activeModel = header.activeModel;
+        readImage();
+    }
+
+    // Validate the parts of the image and build what is derived from them
+    void prepare() {
+        inputHandler.validate();
+        mixer.validate(MAX_CHANNELS);
+        curves.validate(mixer.config);  // Uses the mixer's curve points
+    }
+
+    // Make another slot the active model, false if there is no such slot
+    bool select(uint8_t slot) {
+        if (slot >= MODEL_SLOTS) return false;
+        unsigned long startTime = micros();
+
+        activeModel = slot;
+        headerPending = true;      // Written by service()
+        saveSlot = MODEL_NO_SAVE;  // A save or copy of the previous model stops here, its slot stays invalid
+        readImage();
+        prepare();
+        applyChannelConfigs();
+
+        // Every cached config on the panel is stale now
+        for (int i = 0; i < MAX_CHANNELS; ++i) {
+            inputHandler.markChanged(i);
+        }
+
+        switchMicros = micros() - startTime;
+        return true;
+    }
+
+    // Background writes between frames: the header, then a slot that was reset to defaults
+    void service() {
+        if (!eeprom_is_ready()) return;  // The last byte is still being written
+        PROFILE_SCOPE(PROFILE_EEPROM);
+        if (headerPending) {
+            ModelStoreHeader header = {MODEL_STORE_VERSION, activeModel};
+            for (uint8_t i = 0; i < sizeof(header); ++i) {
+                if (EEPROM.read(MODEL_HEADER_ADDRESS + i) != ((uint8_t*)&header)[i]) {
+                    EEPROM.write(MODEL_HEADER_ADDRESS + i, ((uint8_t*)&header)[i]);
+                    return;
+                }
+            }
+            headerPending = false;
+        } else if (saveSlot != MODEL_NO_SAVE) {
+            // The image bytes (the CRC is summed on the way, parts are in CRC order), then
+            // the CRC, then the version
+            if (saveOffset < sizeof(ModelImage)) {
+                uint8_t value = imageByte(saveOffset);
+                if (saveOffset >= offsetof(ModelImage, channels)) saveCrcValue = _crc16_update(saveCrcValue, value);
+                EEPROM.update(address(saveSlot, saveOffset), value);
+            } else if (saveOffset < sizeof(ModelImage) + sizeof(saveCrcValue)) {
+                uint8_t index = saveOffset - sizeof(ModelImage);
+                EEPROM.update(address(saveSlot, offsetof(ModelImage, crc)) + index, ((uint8_t*)&saveCrcValue)[index]);
+            } else {
+                EEPROM.update(address(saveSlot, offsetof(ModelImage, version)), MODEL_VERSION);  // Marks the slot valid
+                saveSlot = MODEL_NO_SAVE;
+                return;
+            }
+            saveOffset++;
+        }
+    }
+
+    // Start copying the active model into another slot (to set up a new model from this
+    // one), written by service(). False if there is no such slot or a slot is being saved.
+    bool copyTo(uint8_t slot) {
+        if (slot >= MODEL_SLOTS || saveSlot != MODEL_NO_SAVE) return false;
+        startBackgroundSave(slot);
+        return true;
+    }
+
+    // Slot being written in the background, MODEL_NO_SAVE once it is done
+    uint8_t savingSlot() const {
+        return saveSlot;
+    }
+
+    // Persist one part of the active model after it changed
+    void saveChannels() {
+        PROFILE_SCOPE(PROFILE_EEPROM);
+        inputHandler.saveToEEPROM(address(activeModel, offsetof(ModelImage, channels)));
+        saveCrc(activeModel);
+    }
+
+    void saveFailsafes() {
+        PROFILE_SCOPE(PROFILE_EEPROM);
+        EEPROM.put(address(activeModel, offsetof(ModelImage, failsafe)), inputHandler.failsafe);
+        saveCrc(activeModel);
+    }
+
+    // Rate classes and the keyframe interval: how the model's channels go on the air
+    void saveRateClasses() {
+        PROFILE_SCOPE(PROFILE_EEPROM);
+        EEPROM.put(address(activeModel, offsetof(ModelImage, rateClass)), inputHandler.rateClass);
+        EEPROM.update(address(activeModel, offsetof(ModelImage, keyframeInterval)), inputHandler.keyframeInterval);
+        saveCrc(activeModel);
+    }
+
+    void saveMixer() {
+        PROFILE_SCOPE(PROFILE_EEPROM);
+        mixer.saveToEEPROM(address(activeModel, offsetof(ModelImage, mixer)));
+        saveCrc(activeModel);
+    }
+
+    void saveCurves() {
+        PROFILE_SCOPE(PROFILE_EEPROM);
+        curves.saveToEEPROM(address(activeModel, offsetof(ModelImage, curves)));
+        saveCrc(activeModel);
+    }
+
+private:
+    static int address(uint8_t slot, size_t offset) {
+        return MODEL_SLOTS_ADDRESS + slot * (int)sizeof(ModelImage) + (int)offset;
+    }
+
+    static uint16_t updateCrc(uint16_t crc, const void* data, size_t size) {
+        const uint8_t* bytes = (const uint8_t*)data;
+        for (size_t i = 0; i < size; ++i) {
+            crc = _crc16_update(crc, bytes[i]);
+        }
+        return crc;
+    }
+
+    // Copy size bytes from EEPROM into RAM, adding them to the CRC on the way
+    static uint16_t readPart(int address, void* data, size_t size, uint16_t crc) {
+        uint8_t* bytes = (uint8_t*)data;
+        for (size_t i = 0; i < size; ++i) {
+            bytes[i] = EEPROM.read(address + i);
+            crc = _crc16_update(crc, bytes[i]);
+        }
+        return crc;
+    }
+
+    // Byte of the RAM image at an offset into ModelImage, the version and CRC are 0 until
+    // the end of a background save
+    static uint8_t imageByte(size_t offset) {
+        const struct {
+            size_t offset;
+            const void* data;
+            size_t size;
+        } parts[] = {
+            {offsetof(ModelImage, channels), inputHandler.channels, sizeof(inputHandler.channels)},
+            {offsetof(ModelImage, failsafe), inputHandler.failsafe, sizeof(inputHandler.failsafe)},
+            {offsetof(ModelImage, rateClass), inputHandler.rateClass, sizeof(inputHandler.rateClass)},
+            {offsetof(ModelImage, keyframeInterval), &inputHandler.keyframeInterval, sizeof(inputHandler.keyframeInterval)},
+            {offsetof(ModelImage, mixer), &mixer.config, sizeof(mixer.config)},
+            {offsetof(ModelImage, curves), &curves.config, sizeof(curves.config)}
+        };
+        for (const auto& part : parts) {
+            if (offset >= part.offset && offset - part.offset < part.size) {
+                return ((const uint8_t*)part.data)[offset - part.offset];
+            }
+        }
+        return 0;
+    }
+
+    // CRC of the RAM image, in slot order
+    static uint16_t imageCrc() {
+        uint16_t crc = 0xFFFF;
+        crc = updateCrc(crc, inputHandler.channels, sizeof(inputHandler.channels));
+        crc = updateCrc(crc, inputHandler.failsafe, sizeof(inputHandler.failsafe));
+        crc = updateCrc(crc, inputHandler.rateClass, sizeof(inputHandler.rateClass));
+        crc = updateCrc(crc, &inputHandler.keyframeInterval, sizeof(inputHandler.keyframeInterval));
+        crc = updateCrc(crc, &mixer.config, sizeof(mixer.config));
+        crc = updateCrc(crc, &curves.config, sizeof(curves.config));
+        return crc;
+    }
+
+    // Fill the RAM image from the active slot in one pass, a slot that was never written
+    // or fails its CRC is reset to defaults and saved in the background
+    void readImage() {
+        uint8_t slot = activeModel;
+        uint8_t version = EEPROM.read(address(slot, offsetof(ModelImage, version)));
+        uint16_t storedCrc;
+        EEPROM.get(address(slot, offsetof(ModelImage, crc)), storedCrc);
+
+        uint16_t crc = 0xFFFF;
+        crc = readPart(address(slot, offsetof(ModelImage, channels)), inputHandler.channels, sizeof(inputHandler.channels), crc);
+        crc = readPart(address(slot, offsetof(ModelImage, failsafe)), inputHandler.failsafe, sizeof(inputHandler.failsafe), crc);
+        crc = readPart(address(slot, offsetof(ModelImage, rateClass)), inputHandler.rateClass, sizeof(inputHandler.rateClass), crc);
+        crc = readPart(address(slot, offsetof(ModelImage, keyframeInterval)), &inputHandler.keyframeInterval, sizeof(inputHandler.keyframeInterval), crc);
+        crc = readPart(address(slot, offsetof(ModelImage, mixer)), &mixer.config, sizeof(mixer.config), crc);
+        crc = readPart(address(slot, offsetof(ModelImage, curves)), &curves.config, sizeof(curves.config), crc);
+
+        if (version != MODEL_VERSION || crc != storedCrc) {
+            inputHandler.reset();
+            mixer.reset();
+            curves.reset();
+            startBackgroundSave(slot);
+        }
+    }
+
+    void startBackgroundSave(uint8_t slot) {
+        saveSlot = slot;
+        saveOffset = 0;  // Clears the version byte first
+        saveCrcValue = 0xFFFF;
+    }
+
+    void saveCrc(uint8_t slot) {
+        if (saveSlot != MODEL_NO_SAVE) {
+            // Every background save writes the RAM image and sums the CRC as it goes, a
+            // change under it starts it over
+            startBackgroundSave(saveSlot);
+            if (slot == saveSlot) return;
+        }
+        EEPROM.put(address(slot, offsetof(ModelImage, crc)), imageCrc());
+    }
+
+    bool headerPending;      // The header does not hold activeModel yet
+    uint8_t saveSlot;        // Slot being saved in the background, or MODEL_NO_SAVE
+    size_t saveOffset;       // Next byte of it
+    uint16_t saveCrcValue;   // CRC of the bytes saved so far
+};
+
+// The model store, defined here as it works on the config objects in DataDefinitions.h
+ModelStore modelStore;
+
+#endif
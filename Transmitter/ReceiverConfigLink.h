@@ -0,0 +1,118 @@
+#ifndef RECEIVER_CONFIG_LINK_H
+#define RECEIVER_CONFIG_LINK_H
+
+#include <Arduino.h>
+#include <util/crc16.h>
+#include <RCLink.h>
+
+// Over-the-air receiver configuration (tools/rx_config.py). The config is staged over the
+// serial link ("JR<offset>=<hex>"), then "JRS" sends it as config messages (RCLink.h):
+// the chunks, a commit with the CRC, and a status message whose ack payload carries the
+// receiver's verdict on the commit. One message goes out per frame period, with an ack
+// request, once the control frame is off the air and only if the message and its ack
+// fit before the next frame. A message that is not acked or does not fit is sent in a
+// later slot, so control frames are never delayed.
+
+const unsigned long CONFIG_ACK_WAIT_US = 750;    // setRetries(2, 0) in Transmitter.ino
+const unsigned long CONFIG_AIRTIME_US = rcFrameAirtime(RC_FRAME_SIZE) + CONFIG_ACK_WAIT_US;  // Worst case
+const uint8_t CONFIG_MAX_TRIES = 40;             // Slots per message (200 ms) before giving up
+
+class ReceiverConfigLink {
+public:
+    enum State : uint8_t {
+        CONFIG_IDLE,
+        CONFIG_SENDING,
+        CONFIG_APPLIED,     // The receiver applied and stores the config
+        CONFIG_REJECTED,    // The receiver refused it (CRC or invalid values)
+        CONFIG_FAILED       // A message went unacknowledged too often
+    };
+
+    State state;
+    ReceiverStatus receiver;   // Ack payload last received
+    uint16_t attempts;         // Messages sent for the current config
+
+    ReceiverConfigLink() : state(CONFIG_IDLE), attempts(0), step(0), sequence(0),
+                           commitSequence(0), tries(0) {
+        memset(&receiver, 0, sizeof(receiver));
+        memset(&config, 0, sizeof(config));
+    }
+
+    bool pending() const { return state == CONFIG_SENDING; }
+
+    // Stage part of the config, refused while one is being sent
+    bool stage(uint8_t offset, const uint8_t* bytes, uint8_t size) {
+        if (pending() || offset + size > sizeof(config)) return false;
+        memcpy((uint8_t*)&config + offset, bytes, size);
+        return true;
+    }
+
+    // Send the staged config
+    bool start() {
+        if (pending() || config.version != RC_RECEIVER_CONFIG_VERSION) return false;
+        crc = 0xFFFF;
+        for (uint8_t i = 0; i < sizeof(config); ++i) {
+            crc = _crc16_update(crc, ((const uint8_t*)&config)[i]);
+        }
+        state = CONFIG_SENDING;
+        step = 0;
+        tries = 0;
+        attempts = 0;
+        return true;
+    }
+
+    // Build the current message, returns its length
+    uint8_t message(uint8_t modelId, RadioFrame& frame) {
+        frame.modelId = modelId;
+        frame.layout = RC_FRAME_CONFIG;
+        frame.data[0] = sequence;
+        uint8_t size = 0;
+        if (step < chunkCount()) {
+            uint8_t offset = step * RC_CONFIG_CHUNK;
+            size = min(RC_CONFIG_CHUNK, sizeof(config) - offset);
+            frame.data[1] = offset;
+            memcpy(frame.data + 2, (const uint8_t*)&config + offset, size);
+        } else if (step == chunkCount()) {
+            frame.data[1] = RC_CONFIG_COMMIT;
+            size = sizeof(crc);
+            memcpy(frame.data + 2, &crc, size);
+        } else {
+            frame.data[1] = RC_CONFIG_STATUS;
+        }
+        return RC_FRAME_HEADER_SIZE + 2 + size;
+    }
+
+    // Outcome of the message sent last, with the ack payload if one came
+    void onResult(bool acked, const ReceiverStatus* status) {
+        if (attempts != 0xFFFF) attempts++;
+        if (status) receiver = *status;
+
+        if (acked && step > chunkCount()) {
+            // The status after the commit (or after this status message, which keeps it)
+            if (status && (status->sequence == commitSequence || status->sequence == sequence)) {
+                state = status->result == RC_CONFIG_APPLIED ? CONFIG_APPLIED : CONFIG_REJECTED;
+                return;
+            }
+        } else if (acked) {
+            if (step == chunkCount()) commitSequence = sequence;
+            step++;
+            sequence++;
+            tries = 0;
+            return;
+        }
+        if (++tries >= CONFIG_MAX_TRIES) state = CONFIG_FAILED;
+    }
+
+private:
+    ReceiverConfig config;     // Staged, then sent
+    uint16_t crc;
+    uint8_t step;              // Chunk index, then commit, then status
+    uint8_t sequence;
+    uint8_t commitSequence;
+    uint8_t tries;
+
+    static uint8_t chunkCount() {
+        return (sizeof(ReceiverConfig) + RC_CONFIG_CHUNK - 1) / RC_CONFIG_CHUNK;
+    }
+};
+
+#endif
@@ -0,0 +1,140 @@
+#ifndef SERIAL_BRIDGE_H
+#define SERIAL_BRIDGE_H
+
+#include <Arduino.h>
+#include <util/crc16.h>
+#include <RCLink.h>
+
+// Serial-to-radio bridge (tools/bridge.py): a ground station or test rig streams channel
+// values over the serial link and they go out in the next radio frame. "W" switches the
+// link from commands to binary bridge records until an 'E' record ends the mode.
+//
+// Records: sync byte, type, payload, CRC-8 (CCITT, from the type on).
+//   'W' channels: uint16 override mask, uint16 mix mask, then one byte per channel set in
+//       either mask, in channel order. Override channels replace the local value, mix
+//       channels add (value - 128) to it. A channel in both masks is overridden.
+//   'E' end of bridge mode (no payload), answered with "Y"
+// Only the latest record is kept. If none arrives for BRIDGE_TIMEOUT_MS the local sticks
+// take over again until the stream resumes. After BRIDGE_EXIT_MS without a valid record
+// (the host is gone) bridge mode ends by itself and the link takes commands again.
+
+const uint8_t BRIDGE_SYNC = 0xA5;
+const unsigned long BRIDGE_TIMEOUT_MS = 100;   // 20 frames
+const unsigned long BRIDGE_EXIT_MS = 1000;
+const uint8_t BRIDGE_RECORD_SIZE = 2 + 4 + RC_CHANNEL_COUNT + 1;
+
+class SerialBridge {
+public:
+    // What feed() made of a byte
+    enum FeedResult : uint8_t {
+        BRIDGE_PENDING,   // Record incomplete (or dropped)
+        BRIDGE_FRAME,     // New channel values
+        BRIDGE_END        // The host ended bridge mode
+    };
+
+    bool active;
+    uint16_t frames;      // Valid channel records
+    uint16_t errors;      // Records dropped for a bad CRC or type
+    uint16_t timeouts;    // Stream stalls that handed control back to the local sticks
+
+    SerialBridge() : active(false), frames(0), errors(0), timeouts(0), stalled(true),
+                     overrideMask(0), mixMask(0), lastFrameMillis(0), received(0) {}
+
+    void start() {
+        active = true;
+        stalled = true;
+        overrideMask = mixMask = 0;
+        received = 0;
+        lastFrameMillis = millis();  // The exit timeout counts from here until a record arrives
+    }
+
+    // No valid record for BRIDGE_EXIT_MS, the host stopped without an 'E' record
+    bool abandoned() const {
+        return active && millis() - lastFrameMillis > BRIDGE_EXIT_MS;
+    }
+
+    void stop() {
+        active = false;
+        overrideMask = mixMask = 0;
+    }
+
+    // Collect one byte of a bridge record
+    FeedResult feed(uint8_t byte) {
+        if (received == 0 && byte != BRIDGE_SYNC) return BRIDGE_PENDING;  // Resynchronize
+        buffer[received++] = byte;
+
+        if (received == 2 && buffer[1] != 'W' && buffer[1] != 'E') {
+            return drop();
+        }
+        uint8_t length = buffer[1] == 'E' ? 3 : 6;
+        if (received >= 6 && buffer[1] == 'W') {
+            uint16_t channels = buffer[2] | buffer[4] | ((buffer[3] | buffer[5]) << 8);
+            if (channels >> RC_CHANNEL_COUNT) return drop();  // No such channel
+            length += channelCount(channels) + 1;
+        }
+        if (received < length) return BRIDGE_PENDING;
+
+        uint8_t crc = 0;
+        for (uint8_t i = 1; i < length - 1; ++i) {
+            crc = _crc8_ccitt_update(crc, buffer[i]);
+        }
+        if (crc != buffer[length - 1]) return drop();
+        received = 0;
+
+        if (buffer[1] == 'E') return BRIDGE_END;
+
+        overrideMask = buffer[2] | (buffer[3] << 8);
+        mixMask = buffer[4] | (buffer[5] << 8);
+        const uint8_t* data = buffer + 6;
+        for (uint8_t i = 0; i < RC_CHANNEL_COUNT; ++i) {
+            if ((overrideMask | mixMask) & (1u << i)) values[i] = *data++;
+        }
+        lastFrameMillis = millis();
+        stalled = false;
+        if (frames != 0xFFFF) frames++;
+        return BRIDGE_FRAME;
+    }
+
+    // Combine the latest host values with the local ones, unless the stream stalled
+    void apply(uint8_t* local) {
+        if (!active || stalled) return;
+        if (millis() - lastFrameMillis > BRIDGE_TIMEOUT_MS) {
+            stalled = true;
+            if (timeouts != 0xFFFF) timeouts++;
+            return;
+        }
+
+        for (uint8_t i = 0; i < RC_CHANNEL_COUNT; ++i) {
+            if (overrideMask & (1u << i)) {
+                local[i] = values[i];
+            } else if (mixMask & (1u << i)) {
+                local[i] = constrain((int16_t)local[i] + values[i] - 128, 0, 255);
+            }
+        }
+    }
+
+private:
+    bool stalled;                  // No record within the timeout, local sticks only
+    uint16_t overrideMask;
+    uint16_t mixMask;
+    uint8_t values[RC_CHANNEL_COUNT];
+    unsigned long lastFrameMillis;
+    uint8_t buffer[BRIDGE_RECORD_SIZE];
+    uint8_t received;
+
+    static uint8_t channelCount(uint16_t channels) {
+        uint8_t count = 0;
+        for (uint8_t i = 0; i < RC_CHANNEL_COUNT; ++i) {
+            if (channels & (1u << i)) count++;
+        }
+        return count;
+    }
+
+    FeedResult drop() {
+        received = 0;
+        if (errors != 0xFFFF) errors++;
+        return BRIDGE_PENDING;
+    }
+};
+
+#endif
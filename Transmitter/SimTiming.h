@@ -0,0 +1,243 @@
+#ifndef SIM_TIMING_H
+#define SIM_TIMING_H
+
+#ifdef SIM_TIMING
+
+// Timing script for the emulator build (tools/avr_timing.py). Runs once at the end of
+// setup(): each hot path is executed a few times and its worst cycle count reported.
+// The radio is absent (cmnHandler has no RF24), so frames are built but not sent, and
+// serial commands are fed from the table below instead of the UART.
+
+// One device per input type and reader kind, read through channel 0. 'A' 9 has no
+// predefined pins and takes the generic analogRead path.
+struct TimingDevice {
+    char type;
+    uint8_t id;
+    char name[8];
+};
+
+const TimingDevice timingDevices[] PROGMEM = {
+    {'A', 1, "analog"}, {'D', 1, "digital"}, {'S', 1, "switch"},
+    {'E', 1, "extAdc"}, {'B', 1, "swBank"}, {'A', 9, "generic"}
+};
+
+// Channel::read as it was before the readers were specialized: a switch on the input type
+// every call and the core's analogRead/digitalRead resolving the pin at runtime. Reported
+// as readLegacy:<device> next to read:<device> for the on-chip devices, so the timing run
+// compares both on the same firmware.
+struct LegacyChannel {
+    InputType inputType;
+    int pin;
+    int pin2;
+    bool reverse;
+    int trim;
+    int analogReadMin;
+    int analogReadMax;
+    int minEndpoint;
+    int maxEndpoint;
+    int centerPoint;
+
+    LegacyChannel(const ChannelConfig& config, const PredefinedDevice& device)
+        : inputType(config.deviceType == THREE_STATE_SWITCH ? THREE_STATE :
+                    config.deviceType == DIGITAL_INPUT ? DIGITAL : ANALOG),
+          pin(device.primaryPin), pin2(device.secondaryPin), reverse(config.reverse), trim(config.trim),
+          analogReadMin(config.analogReadMin), analogReadMax(config.analogReadMax),
+          minEndpoint(config.minEndpoint), maxEndpoint(config.maxEndpoint), centerPoint(127) {}
+
+    int read() {
+        int value = 0;
+        switch (inputType) {
+            case ANALOG:
+                value = analogRead(pin);
+                value = map(value, analogReadMin, analogReadMax, minEndpoint, maxEndpoint);
+                break;
+            case DIGITAL:
+                value = digitalRead(pin);
+                value = map(value, LOW, HIGH, minEndpoint, maxEndpoint);
+                break;
+            case THREE_STATE:
+                value = readSwitch();
+                break;
+            default:
+                value = 0;
+                break;
+        }
+        if (reverse) {
+            value = 255 - value;
+        }
+        return constrain(value + trim, 0, 255);
+    }
+
+    int readSwitch() {
+        int state1 = digitalRead(pin);
+        int state2 = digitalRead(pin2);
+        if (state1 == LOW && state2 == HIGH) {
+            return minEndpoint;
+        } else if (state1 == HIGH && state2 == LOW) {
+            return maxEndpoint;
+        }
+        return centerPoint;
+    }
+};
+
+// One command per letter of the panel protocol. Writes only touch channel 0's config,
+// failsafe and rate class and the keyframe interval, which are put back after every
+// command (TimingModel) so each command and every later result sees the same model.
+const char timingCommand0[] PROGMEM = "X";
+const char timingCommand1[] PROGMEM = "A0";
+const char timingCommand2[] PROGMEM = "B0";
+const char timingCommand3[] PROGMEM = "K55";
+const char timingCommand4[] PROGMEM = "C0";
+const char timingCommand5[] PROGMEM = "D0=4";
+const char timingCommand6[] PROGMEM = "E0,0";
+const char timingCommand7[] PROGMEM = "F";
+const char timingCommand8[] PROGMEM = "F0=0";
+const char timingCommand9[] PROGMEM = "G";
+const char timingCommand10[] PROGMEM = "H";
+const char timingCommand11[] PROGMEM = "I0";
+const char timingCommand12[] PROGMEM = "L";
+const char timingCommand13[] PROGMEM = "MS";
+const char timingCommand14[] PROGMEM = "M0";
+const char timingCommand15[] PROGMEM = "P";
+const char timingCommand16[] PROGMEM = "Q";
+const char timingCommand17[] PROGMEM = "R0";
+const char timingCommand18[] PROGMEM = "T0,0";
+const char timingCommand19[] PROGMEM = "U1";
+const char timingCommand20[] PROGMEM = "V0";
+const char timingCommand21[] PROGMEM = "Z0,0,1023";
+const char timingCommand22[] PROGMEM = "J";
+const char timingCommand23[] PROGMEM = "J0=0";
+const char timingCommand24[] PROGMEM = "JD";
+const char timingCommand25[] PROGMEM = "JD=0";
+const char timingCommand26[] PROGMEM = "WS";
+const char timingCommand27[] PROGMEM = "JR";
+
+const char* const timingCommands[] PROGMEM = {
+    timingCommand0, timingCommand1, timingCommand2, timingCommand3, timingCommand4,
+    timingCommand5, timingCommand6, timingCommand7, timingCommand8, timingCommand9,
+    timingCommand10, timingCommand11, timingCommand12, timingCommand13, timingCommand14,
+    timingCommand15, timingCommand16, timingCommand17, timingCommand18, timingCommand19,
+    timingCommand20, timingCommand21, timingCommand22, timingCommand23,
+    timingCommand24, timingCommand25, timingCommand26, timingCommand27
+};
+
+// The parts of the active model the command table writes
+struct TimingModel {
+    ChannelConfig channel;
+    uint8_t failsafe;
+    uint8_t rateClass;
+    uint8_t keyframeInterval;
+
+    void save() {
+        channel = inputHandler.channels[0];
+        failsafe = inputHandler.failsafe[0];
+        rateClass = inputHandler.rateClass[0];
+        keyframeInterval = inputHandler.keyframeInterval;
+    }
+
+    // Back into RAM and EEPROM (only changed bytes are written) and reapplied
+    void restore() {
+        inputHandler.channels[0] = channel;
+        inputHandler.failsafe[0] = failsafe;
+        inputHandler.rateClass[0] = rateClass;
+        inputHandler.keyframeInterval = keyframeInterval;
+        modelStore.saveChannels();
+        modelStore.saveFailsafes();
+        modelStore.saveRateClasses();
+        applyChannelConfigs();
+    }
+};
+
+void runTimingScript() {
+    startCycleCounter();
+
+    reportTiming(F("updateInputs"), worstCycles([] { cmnHandler.updateInputs(); }));
+    reportTiming(F("frame"), worstCycles([] {
+        cmnHandler.updateInputs();
+        cmnHandler.sendRadioUpdates();
+    }));
+    inputHandler.keyframeInterval = 10;
+    reportTiming(F("frame"), "delta", worstCycles([] {
+        cmnHandler.updateInputs();
+        cmnHandler.sendRadioUpdates();
+    }));
+    inputHandler.keyframeInterval = DELTA_MODE_OFF;
+
+    // Channel::read per input type
+    ChannelConfig savedConfig = inputHandler.channels[0];
+    for (const TimingDevice& entry : timingDevices) {
+        TimingDevice device;
+        memcpy_P(&device, &entry, sizeof(device));
+        inputHandler.initializeChannel(0, device.type, device.id);
+        applyChannelConfigs();
+        reportTiming(F("read"), device.name, worstCycles([] { channels[0].read(); }));
+
+        const ChannelConfig& config = inputHandler.channels[0];
+        const PredefinedDevice* pins = inputHandler.getPredefinedDevice(config.deviceType, config.deviceId);
+        if (pins != nullptr && config.deviceType != EXTERNAL_ANALOG && config.deviceType != BANK_SWITCH) {
+            LegacyChannel legacy(config, *pins);
+            reportTiming(F("readLegacy"), device.name, worstCycles([&legacy] { legacy.read(); }));
+        }
+    }
+    inputHandler.channels[0] = savedConfig;
+    applyChannelConfigs();
+
+    TimingModel model;
+    model.save();
+    for (uint8_t i = 0; i < sizeof(timingCommands) / sizeof(timingCommands[0]); i++) {
+        char text[16];
+        strncpy_P(text, (PGM_P)pgm_read_word(&timingCommands[i]), sizeof(text));
+        String command(text);
+        reportTiming(F("processCommand"), text, worstCycles([&command] { cmnHandler.processCommand(command); }));
+        model.restore();
+    }
+
+    // One full loop() pass, with a frame due and in the idle time between frames
+    reportTiming(F("loop"), "frame", worstCycles([] {
+        cmnHandler.lastSendTime = micros() - FRAME_PERIOD_US;
+        cmnHandler.loop();
+    }));
+    reportTiming(F("loop"), "idle", worstCycles([] {
+        cmnHandler.lastSendTime = micros();
+        cmnHandler.loop();
+    }));
+
+    // Functional checks (expected values in avr_timing_budget.json): bridge mode ends by
+    // itself when the host goes away
+    cmnHandler.bridge.start();
+    delay(BRIDGE_EXIT_MS + 10);
+    cmnHandler.serviceSerial();
+    reportTiming(F("bridgeExit"), !cmnHandler.bridge.active);
+
+    // The longest valid command fits the serial command buffer
+    ChannelCurveConfig savedCurve = curves.config.channels[0];
+    for (const char* c = "V0=255,0,100,100,100,100,100,100\n"; *c; c++) {
+        cmnHandler.receiveCommandByte(*c);
+    }
+    reportTiming(F("commandMaxLength"), curves.config.channels[0].rates[RATE_SETS - 1].expo == 100);
+    curves.config.channels[0] = savedCurve;
+    curves.rebuild(mixer.config);
+    modelStore.saveCurves();
+
+    // Regular frames only grow for due channels: once every channel went out, a frame
+    // with unchanged values is the header and the every-frame channels
+    FrameEncoder encoder;
+    RadioFrame frame;
+    ChannelValues unchanged = *cmnHandler.channelValues;
+    uint8_t length = 0;
+    uint8_t everyFrame = 0;
+    for (uint8_t i = 0; i < MAX_CHANNELS; i++) {
+        if (inputHandler.rateClass[i] == RATE_EVERY_FRAME) everyFrame++;
+    }
+    for (uint8_t i = 0; i < 3; i++) {
+        length = encoder.encode(unchanged, inputHandler.rateClass, DELTA_MODE_OFF, frame);
+    }
+    reportTiming(F("frameIdleLength"), length == RC_FRAME_HEADER_SIZE + everyFrame);
+
+    reportTiming(F("unusedStack"), unusedStack());
+    reportTiming(F("done"), 0);
+}
+
+#endif // SIM_TIMING
+
+#endif
@@ -1,28 +1,64 @@
 #include <SPI.h>
 #include <nRF24L01.h>
 #include <RF24.h>
+#include <Wire.h>
+#include <RCTiming.h>
+#include <RCProfiler.h>
 #include "Channel.h"
 #include "InputHandler.h"
+#include "Mixer.h"
+#include "CurveHandler.h"
 #include "DataDefinitions.h"
 #include "ChannelLoader.h"
+#include "ModelStore.h"
+#include "LatencyLoopback.h"
+#include "SerialBridge.h"
+#include "ReceiverConfigLink.h"
 #include "CommunicationHandler.h"
 
+#ifdef SIM_TIMING
+CommunicationHandler cmnHandler(&channelValues, nullptr);  // No nRF24 in the emulator
+#else
 CommunicationHandler cmnHandler(&channelValues, &radio);
+#endif
+
+#include "SimTiming.h"
 
 void setup() {
     // Initialize radio
     radio.begin();
-    radio.setAutoAck(false);
     radio.setDataRate(RF24_250KBPS);
+    radio.enableDynamicPayloads();  // Frames vary in length, this needs auto-ack on the pipe
+    radio.enableDynamicAck();       // but frames are sent without asking for an ack
+    radio.enableAckPayload();       // except receiver config messages, answered with the receiver's status
+    radio.setRetries(2, 0);         // 750 us for the ack, a lost one is retried in a later slot
     radio.openWritingPipe(my_radio_pipe);
 
-    // Initialize Serial for debugging
-    Serial.begin(9600);
-    Serial.setTimeout(10);
+    // Read the active model (one CRC-checked pass, no EEPROM writes) and send its failsafe
+    // values right away, the receiver gets a safe frame before anything else is set up
+    modelStore.begin();
+    cmnHandler.sendFailsafeFrame();
+
+    // Initialize Serial for the config panel (rate may be renegotiated later)
+    cmnHandler.begin();
+
+    modelStore.prepare();   // Validate the configs, build the curve tables
+    applyChannelConfigs();
+    digitalInputs.begin();  // Pin modes are set, start debouncing from the current levels
+
+    // Start the config generations at an unpredictable value (ADC noise and boot timing)
+    inputHandler.initGenerations(analogRead(A0) ^ (analogRead(A7) << 6) ^ micros());
+
+    cmnHandler.markReady();
 
-    loadChannels();
+#ifdef SIM_TIMING
+    runTimingScript();
+#endif
 }
 
 void loop() {
     cmnHandler.loop();
+#ifdef RC_LATENCY
+    latencyLoopback.service();
+#endif
 }
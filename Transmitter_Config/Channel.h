@@ -2,23 +2,48 @@
 #define CHANNEL_H
 
 #include <Arduino.h>
+#include <RCLink.h>
 
 // Device type labels stored in PROGMEM
 const char deviceType_J[] PROGMEM = "Joystick";
 const char deviceType_A[] PROGMEM = "Analog";
 const char deviceType_S[] PROGMEM = "Switch";
 const char deviceType_D[] PROGMEM = "Digital";
+const char deviceType_E[] PROGMEM = "Ext ADC";
+const char deviceType_B[] PROGMEM = "Sw Bank";
 const char deviceType_N[] PROGMEM = "Null";
 
-// Lookup table for device types
-const char* const deviceTypeNames[] PROGMEM = {
-    deviceType_J,  // 'J'
-    deviceType_A,  // 'A'
-    deviceType_S,  // 'S'
-    deviceType_D,  // 'D'
-    deviceType_N   // 'N'
+// Get the device type name from PROGMEM
+PGM_P getDeviceTypeName(char deviceType) {
+    switch (deviceType) {
+        case 'J': return deviceType_J;
+        case 'A': return deviceType_A;
+        case 'S': return deviceType_S;
+        case 'D': return deviceType_D;
+        case 'E': return deviceType_E;
+        case 'B': return deviceType_B;
+        default:  return deviceType_N;
+    }
+}
+
+// Selectable devices, in the same order as the transmitter's predefinedDevices
+// (the "D" command sends the index into this table)
+struct DeviceOption {
+    char type;
+    uint8_t id;
+};
+
+const DeviceOption deviceOptions[] PROGMEM = {
+    {'J', 1}, {'J', 2}, {'J', 3}, {'J', 4},
+    {'A', 1}, {'A', 2}, {'A', 3}, {'A', 4},
+    {'S', 1}, {'S', 2},
+    {'D', 1}, {'D', 2}, {'D', 3},
+    {'E', 1}, {'E', 2}, {'E', 3}, {'E', 4},
+    {'B', 1}, {'B', 2}, {'B', 3}, {'B', 4}, {'B', 5}, {'B', 6}, {'B', 7}, {'B', 8}
 };
 
+const uint8_t numDeviceOptions = sizeof(deviceOptions) / sizeof(deviceOptions[0]);
+
 // Menu option labels stored in PROGMEM to save RAM
 const char menuOption1[] PROGMEM = "Value:";
 const char menuOption2[] PROGMEM = "Reverse:";
@@ -31,25 +56,19 @@ const char* const menuOptions[] PROGMEM = {
     menuOption1, menuOption2, menuOption3, menuOption4, menuOption5, menuOption6
 };
 
-class Channel {
+// The config fields are the shared ChannelConfig itself, so a "C" reply is read straight
+// into the channel
+class Channel : public ChannelConfig {
 private:
     char name[10];           // Name of the channel (fixed-size buffer)
     uint8_t value;          // Computed value of the channel (fits within 0-255)
     int analogValue;          // Read analog value of the channel (fits within 0-1023)
 
 public:
-    bool reverse;            // Channel reversing
-    int8_t trim;            // Trim adjustment (int16_t to minimize memory usage)
-    uint16_t analogReadMin;    // Minimum analog value
-    uint16_t analogReadMax;    // Maximum analog value
-    int16_t minEndpoint;    // Minimum applied endpoint
-    int16_t maxEndpoint;    // Maximum applied endpoint
-    char deviceType;       // Device type ('J', 'A', 'S', 'D', 'N')
-    uint8_t deviceId;      // Device ID
+    Channel() : Channel(0) {}
 
     Channel(int number)
-        : value(0), reverse(false), trim(0),
-          analogReadMin(0), analogReadMax(1023), deviceType('N'), deviceId(0){
+        : ChannelConfig{0, 'N', 0, false, 0, 0, 1023, 0, 255, 127}, value(0) {
         snprintf(name, sizeof(name), "CH%d", number);
     }
 
@@ -66,13 +85,7 @@ public:
 
     // Get the device type name from PROGMEM
     const char* getDeviceTypeName() const {
-        switch (deviceType) {
-            case 'J': return deviceType_J;
-            case 'A': return deviceType_A;
-            case 'S': return deviceType_S;
-            case 'D': return deviceType_D;
-            default:  return deviceType_N;
-        }
+        return ::getDeviceTypeName(deviceType);
     }
 
     void getMenuOption(uint8_t index, char* buffer, size_t bufferSize) const {
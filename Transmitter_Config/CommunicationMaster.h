@@ -2,8 +2,21 @@
 #include <avr/common.h>
 #include "Channel.h"
 
-// Assuming you have an array of 10 channels
-extern Channel channels[10];
+extern Channel channels[RC_CHANNEL_COUNT];
+
+// Serial link rates tried from fastest to slowest when negotiating with the transmitter
+// ("B<baud>" then a "K" echo test). The link always starts at defaultBaudRate.
+const unsigned long defaultBaudRate = 9600;
+const uint32_t linkBaudRates[] PROGMEM = {1000000, 500000, 250000, 115200, 57600};
+const unsigned long baudProbationTime = 300;  // Longer than the transmitter's echo-test window
+const uint8_t maxLinkTimeouts = 3;            // Consecutive timeouts before renegotiating
+const unsigned long transmitterBootTimeout = 2000;  // Longest wait for the transmitter at startup
+
+// Printable test pattern for the echo test, rich in bit transitions
+const char linkTestPattern[] PROGMEM = "U*U*~0aZ5j";
+
+unsigned long linkBaudRate = defaultBaudRate;
+uint8_t linkTimeouts = 0;  // Consecutive requests without a reply
 
 void clearSerialBuffer() {
     while (Serial.available() > 0) {
@@ -11,27 +24,123 @@ void clearSerialBuffer() {
     }
 }
 
+// Wait until count bytes are buffered, tracking consecutive timeouts for the link fallback
+bool waitForBytes(int count, unsigned long timeout) {
+    unsigned long startTime = millis();
+    while (Serial.available() < count) {
+        if (millis() - startTime > timeout) {
+            linkTimeouts++;
+            return false;
+        }
+    }
+    linkTimeouts = 0;
+    return true;
+}
+
+// Wait for the transmitter's confirmation message, true if it accepted the change ("Y")
+bool waitForAck() {
+    if (!waitForBytes(1, 1000)) {
+        return false;
+    }
+
+    // Read the confirmation message to confirm the change
+    bool accepted = (Serial.read() == 'Y');
+    while (Serial.available()) {
+        Serial.read();  // Discard the rest of the line
+    }
+    return accepted;
+}
+
+// Ask the transmitter to switch to rate, true if it accepted ("Y")
+bool requestBaudRate(unsigned long rate) {
+    clearSerialBuffer();
+    Serial.print(F("B"));
+    Serial.println(rate);
+
+    if (!waitForBytes(3, 100)) {  // "Y\r\n" or "N\r\n"
+        return false;
+    }
+    bool accepted = (Serial.read() == 'Y');
+    clearSerialBuffer();
+    return accepted;
+}
+
+// Send the test pattern and check that it comes back intact
+bool echoTest() {
+    char pattern[sizeof(linkTestPattern)];
+    strcpy_P(pattern, linkTestPattern);
+    uint8_t length = strlen(pattern);
+
+    clearSerialBuffer();
+    Serial.print(F("K"));
+    Serial.println(pattern);
+
+    if (!waitForBytes(length + 2, 50)) {  // Pattern plus "\r\n"
+        return false;
+    }
+    char reply[sizeof(linkTestPattern)];
+    Serial.readBytes(reply, length);
+    clearSerialBuffer();
+    return memcmp(reply, pattern, length) == 0;
+}
+
+// Agree on the fastest rate both sides support, starting from the default rate. A rate that
+// fails the echo test is abandoned by both sides (the transmitter falls back on its own).
+void negotiateBaudRate() {
+    Serial.begin(defaultBaudRate);
+    linkBaudRate = defaultBaudRate;
+
+    for (uint8_t i = 0; i < sizeof(linkBaudRates) / sizeof(linkBaudRates[0]); i++) {
+        unsigned long rate = pgm_read_dword(&linkBaudRates[i]);
+
+        if (!requestBaudRate(rate)) {
+            // No reply at all may mean the transmitter is still on an old rate, the garbled
+            // request makes it fall back, so give it one more try
+            delay(baudProbationTime);
+            if (!requestBaudRate(rate)) continue;
+        }
+
+        Serial.flush();
+        Serial.begin(rate);
+        delay(2);  // Let the transmitter finish switching
+
+        if (echoTest()) {
+            linkBaudRate = rate;
+            linkTimeouts = 0;
+            return;
+        }
+
+        // Echo failed: return to the default rate and wait out the transmitter's probation
+        Serial.begin(defaultBaudRate);
+        delay(baudProbationTime);
+    }
+    linkTimeouts = 0;
+}
+
+// Renegotiate when the transmitter stops answering at the current rate
+void serviceSerialLink() {
+    if (linkTimeouts >= maxLinkTimeouts) {
+        negotiateBaudRate();
+    }
+}
+
 void updateChannelValues() {
     // Send the request key "X" to the slave Arduino
     clearSerialBuffer();  // Clear any previous data in the buffer
     Serial.println(F("X"));
 
-    // Wait for all 10 bytes of data to arrive
-    unsigned long startTime = millis();
-    while (Serial.available() < 10) {
-        if (millis() - startTime > 50) {
-            // Timeout after 50ms if no data is received
-            return;
-        }
+    // Wait for one byte per channel to arrive, timeout after 50ms
+    if (!waitForBytes(sizeof(ChannelValues), 50)) {
+        return;
     }
 
     // Read the incoming data into a temporary array
-    byte channelData[10];
-    Serial.readBytes(channelData, 10);
+    ChannelValues channelData;
+    Serial.readBytes((uint8_t*)&channelData, sizeof(channelData));
 
     // Update each channel's value
-    for (int i = 0; i < 10; i++) {
-        channels[i].setValue(channelData[i]);
+    for (int i = 0; i < RC_CHANNEL_COUNT; i++) {
+        channels[i].setValue(channelData.values[i]);
     }
 }
 
@@ -41,12 +150,8 @@ void updateAnalogValue(int channelIndex){
     Serial.println(channelIndex);  // Send the channel index
 
     // Wait for 2 bytes of data (since analog values are 10 bits, packed into 2 bytes)
-    unsigned long startTime = millis();
-    while (Serial.available() < 2) {  // Expecting 2 bytes for `uint16_t`
-        if (millis() - startTime > 50) {
-            Serial.println(F("Timeout: No response"));
-            return;  // Exit the function if no data is received within 50ms
-        }
+    if (!waitForBytes(2, 50)) {
+        return;  // Exit the function if no data is received within 50ms
     }
 
     // Read the 2-byte analog value
@@ -58,37 +163,99 @@ void updateAnalogValue(int channelIndex){
 }
 
 // Function to request a channel configuration
-void updateChannelConfigs(int channelIndex) {
+bool updateChannelConfigs(int channelIndex) {
     // Send request string, e.g., "C0" for channel 0
     clearSerialBuffer();  // Clear any previous data in the buffer
     Serial.print(F("C"));
     Serial.println(channelIndex);
 
     // Wait for the incoming struct data
+    if (!waitForBytes(sizeof(ChannelConfig), 1000)) {
+        return false;
+    }
+
+    // Same schema on both boards: read the struct straight into the channel
+    ChannelConfig& config = channels[channelIndex];
+    Serial.readBytes((uint8_t*)&config, sizeof(ChannelConfig));
+    return true;
+}
+
+// False once the transmitter reported a different schema, its configs are not decoded then
+bool schemaCompatible = true;
+
+// Ask for the transmitter's schema version and compare it with ours, false if the
+// transmitter did not answer
+bool queryTransmitter() {
+    clearSerialBuffer();
+    Serial.println(F("H"));
+
+    if (!waitForBytes(1, 50)) {
+        return false;
+    }
+    schemaCompatible = (Serial.read() == RC_SCHEMA_VERSION);
+    return true;
+}
+
+// Wait until the transmitter answers, polling instead of a fixed startup delay
+bool waitForTransmitter() {
     unsigned long startTime = millis();
-    int structSize = sizeof(ChannelConfig);
-    while (Serial.available() < structSize) {
-        if (millis() - startTime > 1000) {
-            Serial.println(F("Timeout: No response"));
-            return;
+    while (millis() - startTime < transmitterBootTimeout) {
+        if (queryTransmitter()) {
+            return true;
         }
     }
+    return false;
+}
+
+// Generations of the configs cached in channels[], as last reported by the transmitter
+uint16_t cachedGlobalGeneration = 0;
+uint16_t cachedGenerations[RC_CHANNEL_COUNT];
+bool generationCacheValid = false;
 
-    // Read the struct data from the serial buffer
-    byte buffer[structSize];
-    Serial.readBytes(buffer, structSize);
+// Bring the cached channel configs up to date, only re-fetching the ones whose
+// generation moved on the transmitter since they were last fetched
+void syncChannelConfigs() {
+    if (!schemaCompatible) return;
+
+    clearSerialBuffer();  // Clear any previous data in the buffer
+    Serial.println(F("G"));
 
-    // Convert the bytes into a struct
-    ChannelConfig config;
-    memcpy(&config, buffer, structSize);
+    // Wait for the global generation followed by one generation per channel
+    uint16_t generations[1 + RC_CHANNEL_COUNT];
+    if (!waitForBytes(sizeof(generations), 100)) {
+        generationCacheValid = false;  // Unknown state, fetch everything next time
+        return;
+    }
+    Serial.readBytes((uint8_t*)generations, sizeof(generations));
+
+    if (generationCacheValid && generations[0] == cachedGlobalGeneration) {
+        return;  // Nothing changed since the last sync
+    }
 
-    channels[channelIndex].reverse = config.reverse;
-    channels[channelIndex].trim = config.trim;
-    channels[channelIndex].deviceType = config.deviceType;
-    channels[channelIndex].deviceId = config.deviceId;
-    channels[channelIndex].minEndpoint = config.minEndpoint;
-    channels[channelIndex].maxEndpoint = config.maxEndpoint;
+    bool allFetched = true;
+    for (int i = 0; i < RC_CHANNEL_COUNT; i++) {
+        if (generationCacheValid && generations[1 + i] == cachedGenerations[i]) continue;
 
+        if (updateChannelConfigs(i)) {
+            cachedGenerations[i] = generations[1 + i];
+        } else {
+            allFetched = false;
+        }
+    }
+
+    // A failed fetch leaves the cache invalid so the next sync retries everything
+    cachedGlobalGeneration = generations[0];
+    generationCacheValid = allFetched;
+}
+
+// Wait for the reply to a change of a channel config. The menus edit the cached config
+// before sending it, so a refused or unanswered change leaves the cache holding a value
+// the transmitter never took: its generation did not move, so the next sync has to
+// fetch everything again.
+void waitForChannelAck() {
+    if (!waitForAck()) {
+        generationCacheValid = false;
+    }
 }
 
 void reverseChannel(int channelIndex) {
@@ -97,19 +264,7 @@ void reverseChannel(int channelIndex) {
     Serial.print(F("R"));
     Serial.println(channelIndex);
 
-    // Wait for the confirmation message
-    unsigned long startTime = millis();
-    while (!Serial.available()) {
-        if (millis() - startTime > 1000) {
-            Serial.println(F("Timeout: No response"));
-            return;
-        }
-    }
-
-    // Read the confirmation message to confirm the device change
-    while (Serial.available()) {
-        Serial.read();  // Discard any incoming data
-    }
+    waitForChannelAck();
 }
 
 void selectDevice(int channelIndex, int deviceIndex) {
@@ -120,19 +275,7 @@ void selectDevice(int channelIndex, int deviceIndex) {
     Serial.print(F("="));
     Serial.println(deviceIndex);
 
-    // Wait for the confirmation message
-    unsigned long startTime = millis();
-    while (!Serial.available()) {
-        if (millis() - startTime > 1000) {
-            Serial.println(F("Timeout: No response"));
-            return;
-        }
-    }
-
-    // Read the confirmation message to confirm the device change
-    while (Serial.available()) {
-        Serial.read();  // Discard any incoming data
-    }
+    waitForChannelAck();
 }
 
 void sendCalibrationData(int selectedIndex){
@@ -146,19 +289,7 @@ void sendCalibrationData(int selectedIndex){
     Serial.print(F(","));
     Serial.println(channels[selectedIndex].analogReadMax);
 
-    // Wait for the confirmation message
-    unsigned long startTime = millis();
-    while (!Serial.available()) {
-        if (millis() - startTime > 1000) {
-            Serial.println(F("Timeout: No response"));
-            return;
-        }
-    }
-
-    // Read the confirmation message to confirm the device change
-    while (Serial.available()) {
-        Serial.read();  // Discard any incoming data
-    }
+    waitForChannelAck();
 }
 
 void sendTrim(int selectedIndex) {
@@ -169,40 +300,16 @@ void sendTrim(int selectedIndex) {
     Serial.print(F(","));
     Serial.println(channels[selectedIndex].trim);
 
-    // Wait for the confirmation message
-    unsigned long startTime = millis();
-    while (!Serial.available()) {
-        if (millis() - startTime > 1000) {
-            Serial.println(F("Timeout: No response"));
-            return;
-        }
-    }
-
-    // Clear any remaining bytes in the serial buffer
-    while (Serial.available()) {
-        Serial.read();
-    }
+    waitForChannelAck();
 }
 
-sendEndpoints(int selectedIndex){
-  // Send the request key "T" followed by the channel index and trim value
+void sendEndpoints(int selectedIndex){
+    // Send the request key "E" followed by the channel index and min endpoint
     clearSerialBuffer();  // Clear any previous data in the buffer
     Serial.print(F("E"));
     Serial.print(selectedIndex);
     Serial.print(F(","));
     Serial.println(channels[selectedIndex].minEndpoint);
 
-    // Wait for the confirmation message
-    unsigned long startTime = millis();
-    while (!Serial.available()) {
-        if (millis() - startTime > 1000) {
-            Serial.println(F("Timeout: No response"));
-            return;
-        }
-    }
-
-    // Clear any remaining bytes in the serial buffer
-    while (Serial.available()) {
-        Serial.read();
-    }
+    waitForChannelAck();
 }
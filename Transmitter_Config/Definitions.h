@@ -8,20 +8,5 @@ enum MenuLevel {
     ENDPOINT,
     SELECT_DEVICE,
     CALIBRATE,
+    MONITOR,
 };
-
-// Channel configuration structure
-struct ChannelConfig {
-    uint8_t version;       // Configuration version
-    char deviceType;       // Device type ('J', 'A', 'S', 'D')
-    uint8_t deviceId;      // Device ID
-    bool reverse;          // Channel reversing
-    int8_t trim;          // Trim adjustment
-    int analogReadMin;     // Minimum analog read value
-    int analogReadMax;     // Maximum analog read value
-    uint8_t minEndpoint;   // Minimum endpoint
-    uint8_t maxEndpoint;   // Maximum endpoint
-    uint8_t centerPoint;   // Center point adjustment
-};
-
-#define numDeviceOptions 13
\ No newline at end of file
@@ -0,0 +1,33 @@
+#ifndef MENU_DISPLAY_H
+#define MENU_DISPLAY_H
+
+#include <Arduino.h>
+#include <LiquidCrystal_I2C.h>
+
+#ifdef SIM_TIMING
+// The emulator has no LCD, every I2C transfer would end at the address NACK. The timing
+// build draws into this stand-in instead, so a screen's timing is the menu code's own.
+// It counts the bytes the display would have been sent (characters and commands) to
+// show the bus cost next to the cycles.
+class MenuDisplay : public Print {
+public:
+    uint16_t bytesSent;
+
+    MenuDisplay(uint8_t, uint8_t, uint8_t) : bytesSent(0) {}
+
+    void init() {}
+    void backlight() {}
+    void clear() { bytesSent++; }
+    void setCursor(uint8_t, uint8_t) { bytesSent++; }
+    void createChar(uint8_t, uint8_t*) { bytesSent += 9; }  // Address command and 8 rows
+
+    size_t write(uint8_t) {
+        bytesSent++;
+        return 1;
+    }
+};
+#else
+typedef LiquidCrystal_I2C MenuDisplay;
+#endif
+
+#endif
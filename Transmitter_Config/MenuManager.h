@@ -2,116 +2,129 @@
 #define MENUMANAGER_H
 
 #include <Arduino.h>
-#include <LiquidCrystal_I2C.h>
+#include "MenuDisplay.h"
 #include "Channel.h"
 
+// Kinds of menu screens
+enum MenuNodeKind : uint8_t {
+    NODE_LIST,    // Scrollable item list with a cursor, the button selects the item under it
+    NODE_SCREEN   // Custom rendered screen, the encoder edits and the button commits
+};
+
+// Menu node flags
+const uint8_t MENU_BACK_ITEM = 0x01;     // Lists: append a "Back" item that returns to the parent
+const uint8_t MENU_TITLE_CHANNEL = 0x02; // Lists: append the selected channel name to the title
+
+// Static list labels stored in PROGMEM
+const char menuLabelMonitor[] PROGMEM = "Monitor";
+const char menuLabelTrue[] PROGMEM = "True";
+const char menuLabelFalse[] PROGMEM = "False";
+const char menuTitleSettings[] PROGMEM = "Channel: ";
+const char menuTitleReverse[] PROGMEM = "Reverse ";
+const char menuTitleDevice[] PROGMEM = "Select Device";
+
 class MenuManager {
+#ifdef SIM_TIMING
+    friend void runTimingScript();
+#endif
+
 private:
-    LiquidCrystal_I2C* lcd;
+    // One screen of the menu tree. The whole tree lives in PROGMEM (menuNodes, indexed by
+    // MenuLevel) and is interpreted by the generic navigation and render engine below.
+    struct MenuNode {
+        MenuNodeKind kind;
+        uint8_t flags;
+        MenuLevel parent;                                           // Where "Back" (or a plain button press) goes
+        PGM_P title;                                                // Lists: title line, nullptr for a full-height list
+        void (MenuManager::*enter)();                               // Optional: called when the node is entered
+        uint8_t (MenuManager::*itemCount)();                        // Lists: item provider, number of items
+        void (MenuManager::*itemLabel)(uint8_t, char*, uint8_t);    // Lists: item provider, label of one item
+        MenuLevel (MenuManager::*select)(uint8_t);                  // Button action, returns the next node
+        bool (MenuManager::*adjust)(int8_t, uint8_t);               // Screens: encoder editor, true if a redraw is needed
+        void (MenuManager::*render)();                              // Screens: draw the screen
+    };
+    static const uint8_t menuNodeCount = MONITOR + 1;
+    static const MenuNode menuNodes[menuNodeCount];
+
+    MenuDisplay* lcd;
     Channel* channels;
     uint8_t channelCount;  // Number of channels
     uint8_t selectedIndex; // The currently selected channel index
     MenuLevel menuLevel;   // Enum to track the current menu level
-    uint8_t subMenuIndex;  // The index of the selected setting
-    uint8_t scrollOffset;  // The topmost visible item index in settings
+    uint8_t subMenuIndex;  // The list cursor of the current node
+    uint8_t scrollOffset;  // The topmost visible item index (or monitor row)
     unsigned long lastButtonPressTime; // Track the last button press time
     static const unsigned long buttonTimeout = 500; // Timeout for button press in ms
 
-    static const uint8_t maxVisibleItems = 3; // Number of scrollable lines (excluding the title line)
+    static const uint8_t lcdRows = 4;
 
     // New variables for update control
     bool updateFlag;               // Flag indicating if an update is needed
     unsigned long lastUpdateTime;   // Timestamp of the last LCD update
     static const unsigned long updateInterval = 200; // Update interval in milliseconds
 
-public:
-    MenuManager(LiquidCrystal_I2C* lcd, Channel* channels, uint8_t count)
-        : lcd(lcd), channels(channels), channelCount(count), selectedIndex(0),
-          menuLevel(CHANNEL_LIST), subMenuIndex(0), scrollOffset(0),
-          lastButtonPressTime(0), updateFlag(false), lastUpdateTime(0) {}
+    // All-channels monitor layout: 3 slots per row, each a 1-char label and a 5-cell bar
+    static const uint8_t monitorSlotsPerRow = 3;
+    static const uint8_t monitorSlotWidth = 7;
+    static const uint8_t monitorBarCells = 5;
+    static const uint8_t monitorSlots = monitorSlotsPerRow * lcdRows;
+    static const uint8_t monitorNoLevel = 0xFF;
+    uint8_t monitorLevels[monitorSlots]; // Bar level currently drawn in each slot (0-15)
 
-    void handleMissedUpdates(){
-      if(updateFlag){
-        displayMenu();
-      }
+    static void readNode(MenuLevel level, MenuNode& node) {
+        memcpy_P(&node, &menuNodes[level], sizeof(MenuNode));
     }
 
-    void displayMenu() {
-        unsigned long currentTime = millis();
-
-        // Check if the required update interval has passed
-        if (currentTime - lastUpdateTime < updateInterval) {
-            // If interval not passed, set the update flag and return
-            updateFlag = true;
-            return;
-        }
-
-        // Perform the LCD update
-        updateFlag = false;  // Reset the flag
-        lastUpdateTime = currentTime;  // Update the timestamp
+    uint8_t visibleItems(const MenuNode& node) const {
+        return node.title ? lcdRows - 1 : lcdRows;
+    }
 
-        lcd->clear();  // Clear the screen for the new menu display
+    uint8_t listLength(const MenuNode& node) {
+        return (this->*node.itemCount)() + ((node.flags & MENU_BACK_ITEM) ? 1 : 0);
+    }
 
-        switch (menuLevel) {
-            case CHANNEL_LIST:
-                displayChannelList();
-                break;
-            case CHANNEL_SETTINGS:
-                displayChannelSettings();
-                break;
-            case READ_VALUE:
-                displayReadValue();
-                break;
-            case REVERSE:
-                displayReverse();
-                break;
-            case SELECT_DEVICE:
-                displaySelectDevice();
-                break;
-            case CALIBRATE:
-                displayCalibrate();
-                break;
-            case TRIM:
-                displayTrim();
-                break;
-            case ENDPOINT:
-                displayEndpoint();
-                break;
-        }
+    // Move a list index by a number of encoder steps, wrapping around at both ends
+    static uint8_t wrapIndex(uint8_t index, int8_t direction, uint8_t count) {
+        int8_t wrapped = ((int)index - direction) % count;
+        return wrapped < 0 ? wrapped + count : wrapped;
     }
 
-    void displayChannelList() {
-        for (uint8_t i = 0; i < 4; i++) {
-            uint8_t channelIndex = scrollOffset + i;
-            if (channelIndex >= channelCount) break;
+    void navigate(MenuLevel level) {
+        menuLevel = level;
+        subMenuIndex = 0;
+        scrollOffset = 0;
 
-            lcd->setCursor(0, i);
-            lcd->print(channelIndex == selectedIndex ? F("> ") : F("  "));
-            lcd->print(channels[channelIndex].getName());
+        MenuNode node;
+        readNode(level, node);
+        if (node.enter) {
+            (this->*node.enter)();
         }
     }
 
-    void displayChannelSettings() {
-        lcd->setCursor(0, 0);
-        lcd->print(F("Channel: "));
-        lcd->print(channels[selectedIndex].getName());  // Display channel name on the first line
+    void renderList(const MenuNode& node) {
+        uint8_t firstRow = 0;
+        if (node.title) {
+            lcd->setCursor(0, 0);
+            lcd->print((const __FlashStringHelper*)node.title);
+            if (node.flags & MENU_TITLE_CHANNEL) {
+                lcd->print(channels[selectedIndex].getName());
+            }
+            firstRow = 1;
+        }
 
         char buffer[20];
-        uint8_t itemCount = channels[selectedIndex].getMenuOptionCount() + 1; // +1 for the Back option
+        uint8_t itemCount = (this->*node.itemCount)();
+        uint8_t length = listLength(node);
 
-        // Display the scrollable menu options on lines 1 to 3
-        for (uint8_t i = 0; i < maxVisibleItems; i++) {
+        for (uint8_t i = 0; i < visibleItems(node); i++) {
             uint8_t itemIndex = scrollOffset + i;
-            lcd->setCursor(0, i + 1);  // Start at the second line (i + 1)
+            if (itemIndex >= length) break;
 
-            if (itemIndex == subMenuIndex) {
-                lcd->print(F("> "));
-            } else {
-                lcd->print(F("  "));
-            }
+            lcd->setCursor(0, firstRow + i);
+            lcd->print(itemIndex == subMenuIndex ? F("> ") : F("  "));
 
-            if (itemIndex < itemCount - 1) {
-                channels[selectedIndex].getMenuOption(itemIndex, buffer, sizeof(buffer));
+            if (itemIndex < itemCount) {
+                (this->*node.itemLabel)(itemIndex, buffer, sizeof(buffer));
                 lcd->print(buffer);
             } else {
                 lcd->print(F("Back"));
@@ -119,8 +132,55 @@ public:
         }
     }
 
+    // ---- CHANNEL_LIST ----
+
+    void enterChannelList() {
+        subMenuIndex = selectedIndex;
+        scrollOffset = selectedIndex - (selectedIndex % lcdRows);  // Align with the selected index
+    }
+
+    uint8_t channelListCount() {
+        return channelCount + 1;  // +1 for the Monitor entry
+    }
+
+    void channelListLabel(uint8_t index, char* buffer, uint8_t size) {
+        if (index < channelCount) {
+            strncpy(buffer, channels[index].getName(), size);
+        } else {
+            strncpy_P(buffer, menuLabelMonitor, size);  // Last entry opens the all-channels monitor
+        }
+    }
+
+    MenuLevel channelListSelect(uint8_t index) {
+        selectedIndex = index;
+        if (index >= channelCount) {
+            return MONITOR;
+        }
+        updateChannelValues();  // Fresh "Value:" when a channel is opened
+        return CHANNEL_SETTINGS;
+    }
+
+    // ---- CHANNEL_SETTINGS ----
+
+    void enterChannelSettings() {
+        loadChannelSettings(selectedIndex);
+    }
+
+    uint8_t settingsCount() {
+        return channels[selectedIndex].getMenuOptionCount();
+    }
+
+    void settingsLabel(uint8_t index, char* buffer, uint8_t size) {
+        channels[selectedIndex].getMenuOption(index, buffer, size);
+    }
+
+    MenuLevel settingsSelect(uint8_t index) {
+        return channels[selectedIndex].configureItem(index);
+    }
+
+    // ---- READ_VALUE ----
+
     void displayReadValue() {
-        lcd->clear();
         lcd->setCursor(0, 0);
         lcd->print(channels[selectedIndex].getName());
         lcd->print(F(" : "));
@@ -172,76 +232,96 @@ public:
         lcd->print(F("> Back"));
     }
 
-    void displayReverse() {
-        lcd->clear();
-        lcd->setCursor(0, 0);
-        
-        // Display the title "Reverse <channel name>"
-        lcd->print(F("Reverse "));
-        lcd->print(channels[selectedIndex].getName());
+    // ---- MONITOR ----
 
-        // Options: "True", "False", "Back"
-        const char* options[] = {"True", "False", "Back"};
-        uint8_t optionCount = 3;  // Number of options
+    void enterMonitor() {
+        updateChannelValues();
+        lastUpdateTime = 0;  // Draw the monitor immediately
+    }
 
-        // Display the scrollable options
-        for (uint8_t i = 0; i < optionCount; i++) {
-            lcd->setCursor(0, i + 1);  // Start at the second line (i + 1)
-            if (subMenuIndex == i) {
-                lcd->print(F("> "));  // Highlight the selected option
-            } else {
-                lcd->print(F("  "));  // Indent unselected options
-            }
-            lcd->print(options[i]);
+    // Page scrolling ignores the encoder acceleration, a fast turn must not skip rows
+    bool adjustMonitor(int8_t direction, uint8_t /* acceleration */) {
+        // Scroll by rows when there are more channels than slots
+        uint8_t rowCount = (channelCount + monitorSlotsPerRow - 1) / monitorSlotsPerRow;
+        uint8_t pageCount = rowCount > lcdRows ? rowCount - lcdRows + 1 : 1;
+        uint8_t newOffset = wrapIndex(scrollOffset, direction, pageCount);
+        if (newOffset == scrollOffset) {
+            return false;  // Nothing changed, keep the incremental bars
         }
+        scrollOffset = newOffset;
+        return true;
     }
 
-    void displaySelectDevice() {
-        lcd->clear();
-        lcd->setCursor(0, 0);
-        lcd->print(F("Select Device"));  // Static title line
+    // Full redraw of the all-channels monitor: labels plus every bar
+    void displayMonitor() {
+        for (uint8_t slot = 0; slot < monitorSlots; slot++) {
+            monitorLevels[slot] = monitorNoLevel;
 
-        char typeBuffer[16];  // Buffer to hold the device type name
+            uint8_t channelIndex = scrollOffset * monitorSlotsPerRow + slot;
+            if (channelIndex >= channelCount) continue;
 
-        for (uint8_t i = 0; i < maxVisibleItems; i++) {
-            uint8_t optionIndex = scrollOffset + i;
-            lcd->setCursor(0, i + 1);
-            if (optionIndex == subMenuIndex) {
-                lcd->print(F("> "));
-            } else {
-                lcd->print(F("  "));
-            }
+            lcd->setCursor((slot % monitorSlotsPerRow) * monitorSlotWidth, slot / monitorSlotsPerRow);
+            // Channels 1-9 are labelled with their digit, 10 and up continue with 'A', 'B', ...
+            lcd->write(channelIndex < 9 ? '1' + channelIndex : 'A' + (channelIndex - 9));
+        }
+        refreshMonitor();
+    }
 
-            // Check if it's the last option for "Back"
-            if (optionIndex == numDeviceOptions) {
-                lcd->print(F("Back"));
-            } else if (optionIndex < numDeviceOptions) {
-                uint8_t number;
-                if (optionIndex < 4) {
-                    strcpy_P(typeBuffer, (PGM_P)deviceTypeNames[0]);  // "Joystick"
-                    number = optionIndex + 1;
-                } else if (optionIndex < 8) {
-                    strcpy_P(typeBuffer, (PGM_P)deviceTypeNames[1]);  // "Analog"
-                    number = optionIndex - 3;
-                } else if (optionIndex < 10) {
-                    strcpy_P(typeBuffer, (PGM_P)deviceTypeNames[2]);  // "Switch"
-                    number = optionIndex - 7;
-                } else if (optionIndex < 13) {
-                    strcpy_P(typeBuffer, (PGM_P)deviceTypeNames[3]);  // "Digital"
-                    number = optionIndex - 9;
-                } else {
-                    strcpy_P(typeBuffer, (PGM_P)deviceTypeNames[4]);  // "Null" (fallback)
-                    number = 0;
-                }
+    static uint8_t monitorCellGlyph(uint8_t level, uint8_t cell) {
+        int8_t fill = level - cell * 3;
+        return constrain(fill, 0, 3);
+    }
 
-                lcd->print(typeBuffer);  // Print type (e.g., "Joystick")
-                lcd->print(number);      // Print number (e.g., "1")
-            }
+    // ---- REVERSE ----
+
+    uint8_t reverseCount() {
+        return 2;  // "True", "False"
+    }
+
+    void reverseLabel(uint8_t index, char* buffer, uint8_t size) {
+        strncpy_P(buffer, index == 0 ? menuLabelTrue : menuLabelFalse, size);
+    }
+
+    MenuLevel reverseSelect(uint8_t index) {
+        // Only toggle when the requested state differs from the current one
+        if (channels[selectedIndex].reverse != (index == 0)) {
+            reverseChannel(selectedIndex);
         }
+        delay(100);
+        return CHANNEL_SETTINGS;  // Go back to settings menu
+    }
+
+    // ---- SELECT_DEVICE ----
+
+    uint8_t deviceCount() {
+        return numDeviceOptions;
+    }
+
+    void deviceLabel(uint8_t index, char* buffer, uint8_t size) {
+        DeviceOption option;
+        memcpy_P(&option, &deviceOptions[index], sizeof(option));
+
+        // Type name (e.g. "Joystick") followed by its number (e.g. "1")
+        strncpy_P(buffer, getDeviceTypeName(option.type), size);
+        uint8_t length = strlen(buffer);
+        snprintf(buffer + length, size - length, "%u", option.id);
+    }
+
+    MenuLevel deviceSelect(uint8_t index) {
+        selectDevice(selectedIndex, index);
+        delay(100);
+        return CHANNEL_SETTINGS;
+    }
+
+    // ---- CALIBRATE ----
+
+    MenuLevel calibrateCommit(uint8_t) {
+        sendCalibrationData(selectedIndex);
+        delay(100);
+        return CHANNEL_SETTINGS;  // Go back to CHANNEL_SETTINGS
     }
 
     void displayCalibrate() {
-        lcd->clear();
         lcd->setCursor(0, 0);
         lcd->print(F("Calibrate:"));
         lcd->setCursor(0, 1);
@@ -277,8 +357,22 @@ public:
         lcd->print(F("> Back"));
     }
 
+    // ---- TRIM ----
+
+    bool adjustTrim(int8_t direction, uint8_t acceleration) {
+        // Increment or decrement the trim value, clamped between -127 and +127
+        int trimValue = channels[selectedIndex].trim + direction * acceleration;
+        channels[selectedIndex].trim = constrain(trimValue, -127, 127);
+        return true;
+    }
+
+    MenuLevel trimCommit(uint8_t) {
+        sendTrim(selectedIndex);
+        delay(100);
+        return CHANNEL_SETTINGS;  // Go back to CHANNEL_SETTINGS
+    }
+
     void displayTrim() {
-        lcd->clear();
         lcd->setCursor(0, 0);
         lcd->print(F("Trim Adjust:"));
 
@@ -294,246 +388,180 @@ public:
         lcd->print(F("> Back"));
     }
 
+    // ---- ENDPOINT ----
+
+    bool adjustEndpoint(int8_t direction, uint8_t acceleration) {
+        // Adjust both endpoints simultaneously, keeping the range symmetric (min 0-125)
+        int minEndpoint = channels[selectedIndex].minEndpoint + direction * acceleration;
+        channels[selectedIndex].minEndpoint = constrain(minEndpoint, 0, 125);
+        channels[selectedIndex].maxEndpoint = 255 - channels[selectedIndex].minEndpoint;
+        return true;
+    }
+
+    MenuLevel endpointCommit(uint8_t) {
+        sendEndpoints(selectedIndex);
+        delay(100);
+        return CHANNEL_SETTINGS;  // Go back to CHANNEL_SETTINGS
+    }
+
     void displayEndpoint() {
-    lcd->clear();
-    lcd->setCursor(0, 0);
-    lcd->print(F("Endpoint Adjust:"));
+        lcd->setCursor(0, 0);
+        lcd->print(F("Endpoint Adjust:"));
 
-    // Get the min and max endpoint values
-    uint16_t minEndpoint = channels[selectedIndex].minEndpoint;
-    uint16_t maxEndpoint = channels[selectedIndex].maxEndpoint;
+        // Get the min and max endpoint values
+        uint16_t minEndpoint = channels[selectedIndex].minEndpoint;
+        uint16_t maxEndpoint = channels[selectedIndex].maxEndpoint;
 
-    // Calculate the number of filled blocks (proportional to range)
-    int range = maxEndpoint - minEndpoint;
-    int blocksToFill = map(range, 0, 255, 0, 10);  // Map range to 10 blocks
+        // Calculate the number of filled blocks (proportional to range)
+        int range = maxEndpoint - minEndpoint;
+        int blocksToFill = map(range, 0, 255, 0, 10);  // Map range to 10 blocks
 
-    // Calculate left and right empty blocks
-    int leftEmptyBlocks = (10 - blocksToFill) / 2;
-    int rightEmptyBlocks = 10 - blocksToFill - leftEmptyBlocks;
+        // Calculate left and right empty blocks
+        int leftEmptyBlocks = (10 - blocksToFill) / 2;
+        int rightEmptyBlocks = 10 - blocksToFill - leftEmptyBlocks;
 
-    // Draw the progress bar
-    lcd->setCursor(0, 1);
-    lcd->print(F("["));
+        // Draw the progress bar
+        lcd->setCursor(0, 1);
+        lcd->print(F("["));
 
-    for (int i = 0; i < 10; i++) {
-        if (i < leftEmptyBlocks || i >= 10 - rightEmptyBlocks) {
-            lcd->write(0);  // Empty block
-        } else {
-            lcd->write(3);  // Full block
+        for (int i = 0; i < 10; i++) {
+            if (i < leftEmptyBlocks || i >= 10 - rightEmptyBlocks) {
+                lcd->write(0);  // Empty block
+            } else {
+                lcd->write(3);  // Full block
+            }
         }
-    }
-
-    lcd->print(F("]"));
 
-    // Display the current range
-    lcd->setCursor(0, 2);
-    lcd->print(F("Min:"));
-    lcd->print(minEndpoint);
-    lcd->print(F(" Max:"));
-    lcd->print(maxEndpoint);
+        lcd->print(F("]"));
 
-    // Add "Back" option
-    lcd->setCursor(0, 3);
-    lcd->print(F("> Back"));
-}
+        // Display the current range
+        lcd->setCursor(0, 2);
+        lcd->print(F("Min:"));
+        lcd->print(minEndpoint);
+        lcd->print(F(" Max:"));
+        lcd->print(maxEndpoint);
 
+        // Add "Back" option
+        lcd->setCursor(0, 3);
+        lcd->print(F("> Back"));
+    }
 
-void updateEncoder(int8_t direction, bool buttonPressed) {
-    unsigned long currentTime = millis();
+public:
+    MenuManager(MenuDisplay* lcd, Channel* channels, uint8_t count)
+        : lcd(lcd), channels(channels), channelCount(count), selectedIndex(0),
+          menuLevel(CHANNEL_LIST), subMenuIndex(0), scrollOffset(0),
+          lastButtonPressTime(0), updateFlag(false), lastUpdateTime(0) {
+        memset(monitorLevels, monitorNoLevel, sizeof(monitorLevels));
+    }
 
-    switch (menuLevel) {
-        case CHANNEL_LIST: {
-            selectedIndex = (selectedIndex - direction + channelCount) % channelCount;
+    void handleMissedUpdates(){
+      if(updateFlag){
+        displayMenu();
+      }
+    }
 
-            if (selectedIndex < scrollOffset) {
-                scrollOffset = selectedIndex;
-            } else if (selectedIndex >= scrollOffset + maxVisibleItems) {
-                scrollOffset = selectedIndex - maxVisibleItems + 1;
-            }
+    void displayMenu() {
+        unsigned long currentTime = millis();
 
-            if (buttonPressed && (currentTime - lastButtonPressTime > buttonTimeout)) {
-                lastButtonPressTime = currentTime;
-                menuLevel = CHANNEL_SETTINGS;  // Move to CHANNEL_SETTINGS
-                loadChannelSettings(selectedIndex);
-                subMenuIndex = 0;
-                scrollOffset = 0;  // Reset to top
-            }
-            break;
+        // Check if the required update interval has passed
+        if (currentTime - lastUpdateTime < updateInterval) {
+            // If interval not passed, set the update flag and return
+            updateFlag = true;
+            return;
         }
 
-        case CHANNEL_SETTINGS: {
-            uint8_t itemCount = channels[selectedIndex].getMenuOptionCount() + 1;  // +1 for Back option
-            subMenuIndex = (subMenuIndex - direction + itemCount) % itemCount;
+        // Perform the LCD update
+        updateFlag = false;  // Reset the flag
+        lastUpdateTime = currentTime;  // Update the timestamp
 
-            if (subMenuIndex < scrollOffset) {
-                scrollOffset = subMenuIndex;
-            } else if (subMenuIndex >= scrollOffset + maxVisibleItems) {
-                scrollOffset = subMenuIndex - maxVisibleItems + 1;
-            }
+        lcd->clear();  // Clear the screen for the new menu display
 
-            if (buttonPressed && (currentTime - lastButtonPressTime > buttonTimeout)) {
-                lastButtonPressTime = currentTime;
-
-                if (subMenuIndex == itemCount - 1) {
-                    // "Back" selected
-                    menuLevel = CHANNEL_LIST;
-                    loadChannelSettings(selectedIndex);
-                    subMenuIndex = 0;
-                    scrollOffset = selectedIndex - (selectedIndex % maxVisibleItems);  // Align with the selected index
-                } else if (channels[selectedIndex].configureItem(subMenuIndex) == SELECT_DEVICE) {
-                    menuLevel = SELECT_DEVICE;
-                    subMenuIndex = 0;  // Reset to start at Joystick1
-                    scrollOffset = 0;  // Reset scroll to the top
-                } else {
-                    menuLevel = channels[selectedIndex].configureItem(subMenuIndex);
-                }
-            }
-            break;
+        MenuNode node;
+        readNode(menuLevel, node);
+        if (node.kind == NODE_LIST) {
+            renderList(node);
+        } else {
+            (this->*node.render)();
         }
+    }
 
-        case READ_VALUE: {
-            if (buttonPressed && (currentTime - lastButtonPressTime > buttonTimeout)) {
-                lastButtonPressTime = currentTime;
-                menuLevel = CHANNEL_SETTINGS;  // Go back to CHANNEL_SETTINGS
-                loadChannelSettings(selectedIndex);
-                subMenuIndex = 0;
-                scrollOffset = 0;
-            }
-            break;
-        }
+    // Redraw only the monitor bar cells whose glyph changed since the last refresh
+    void refreshMonitor() {
+        for (uint8_t slot = 0; slot < monitorSlots; slot++) {
+            uint8_t channelIndex = scrollOffset * monitorSlotsPerRow + slot;
+            if (channelIndex >= channelCount) break;
 
-        case REVERSE: {
-            uint8_t optionCount = 3;  // "True", "False", "Back"
-            subMenuIndex = (subMenuIndex - direction + optionCount) % optionCount;
-
-            if (buttonPressed && (currentTime - lastButtonPressTime > buttonTimeout)) {
-                lastButtonPressTime = currentTime;
-
-                switch (subMenuIndex) {
-                    case 0:  // "True" selected
-                        if(!channels[selectedIndex].reverse){
-                          reverseChannel(selectedIndex);
-                        }
-                        break;
-
-                    case 1:  // "False" selected
-                        if(channels[selectedIndex].reverse){
-                          reverseChannel(selectedIndex);
-                        }
-                        break;
+            // 5 cells x 3 partial glyphs (1/5, 3/5, full) = 15 levels
+            uint8_t level = ((uint16_t)channels[channelIndex].getValue() * 15 + 127) / 255;
+            uint8_t oldLevel = monitorLevels[slot];
+            if (level == oldLevel) continue;
+            monitorLevels[slot] = level;
+
+            uint8_t column = (slot % monitorSlotsPerRow) * monitorSlotWidth + 1;
+            uint8_t row = slot / monitorSlotsPerRow;
+            bool cursorValid = false;
+
+            for (uint8_t cell = 0; cell < monitorBarCells; cell++) {
+                // Custom characters 0-3 are empty, 1/5, 3/5 and full, so the fill is the glyph
+                uint8_t glyph = monitorCellGlyph(level, cell);
+                if (oldLevel != monitorNoLevel && glyph == monitorCellGlyph(oldLevel, cell)) {
+                    cursorValid = false;  // Skipped a cell, the next write needs a new cursor
+                    continue;
+                }
+                if (!cursorValid) {
+                    lcd->setCursor(column + cell, row);
+                    cursorValid = true;
                 }
-                delay(100);
-                menuLevel = CHANNEL_SETTINGS;  // Go back to settings menu
-                loadChannelSettings(selectedIndex);
-                subMenuIndex = 0;
-                scrollOffset = 0;
+                lcd->write(glyph);
             }
-            break;
         }
+    }
+
+    // direction is the number of detents turned since the last call, acceleration the
+    // speed-based multiplier applied to value editors
+    void updateEncoder(int8_t direction, bool buttonPressed, uint8_t acceleration = 1) {
+        unsigned long currentTime = millis();
+        bool pressed = buttonPressed && (currentTime - lastButtonPressTime > buttonTimeout);
+        if (pressed) {
+            lastButtonPressTime = currentTime;
+        }
+
+        MenuNode node;
+        readNode(menuLevel, node);
+        bool changed = pressed;
 
-        case SELECT_DEVICE: {
-            uint8_t itemCount = numDeviceOptions + 1;  // +1 for Back option
-            subMenuIndex = (subMenuIndex - direction + itemCount) % itemCount;
+        if (node.kind == NODE_LIST) {
+            uint8_t length = listLength(node);
+            subMenuIndex = wrapIndex(subMenuIndex, direction, length);
 
             if (subMenuIndex < scrollOffset) {
                 scrollOffset = subMenuIndex;
-            } else if (subMenuIndex >= scrollOffset + maxVisibleItems) {
-                scrollOffset = subMenuIndex - maxVisibleItems + 1;
+            } else if (subMenuIndex >= scrollOffset + visibleItems(node)) {
+                scrollOffset = subMenuIndex - visibleItems(node) + 1;
             }
+            changed |= direction != 0;
 
-            if (buttonPressed && (currentTime - lastButtonPressTime > buttonTimeout)) {
-                lastButtonPressTime = currentTime;
-
-                if (subMenuIndex == itemCount - 1) {
-                    // "Back" selected
-                    loadChannelSettings(selectedIndex);
-                    subMenuIndex = 0;
-                    scrollOffset = 0;
+            if (pressed) {
+                if ((node.flags & MENU_BACK_ITEM) && subMenuIndex == length - 1) {
+                    navigate(node.parent);  // "Back" selected
                 } else {
-                    selectDevice(selectedIndex, subMenuIndex);
-                    delay(100);
-                    loadChannelSettings(selectedIndex);
-                    subMenuIndex = 0;
-                    scrollOffset = 0;
-                    // Serial.print(F("Selected Device Option: "));
-                    // Serial.println(subMenuIndex);
-                    // Handle the device selection here
+                    navigate((this->*node.select)(subMenuIndex));
                 }
-                menuLevel = CHANNEL_SETTINGS;
             }
-            break;
-        }
-
-        case CALIBRATE: {
-            if (buttonPressed && (currentTime - lastButtonPressTime > buttonTimeout)) {
-                lastButtonPressTime = currentTime;
-                sendCalibrationData(selectedIndex);
-                delay(100);
-                menuLevel = CHANNEL_SETTINGS;  // Go back to CHANNEL_SETTINGS
-                loadChannelSettings(selectedIndex);
-                subMenuIndex = 0;
-                scrollOffset = 0;  // Reset scroll position
+        } else {
+            if (direction != 0 && node.adjust) {
+                changed |= (this->*node.adjust)(direction, acceleration);
             }
-            break;
-        }
-        case TRIM: {
-            // Increment or decrement the trim value
-            channels[selectedIndex].trim += direction;
-
-            // Clamp trim value between -127 and +127
-            if (channels[selectedIndex].trim > 127) channels[selectedIndex].trim = 127;
-            if (channels[selectedIndex].trim < -127) channels[selectedIndex].trim = -127;
-
-            if (buttonPressed && (currentTime - lastButtonPressTime > buttonTimeout)) {
-                lastButtonPressTime = currentTime;
-                sendTrim(selectedIndex);
-                delay(100);
-                menuLevel = CHANNEL_SETTINGS;  // Go back to CHANNEL_SETTINGS
-                loadChannelSettings(selectedIndex);
-                subMenuIndex = 0;
-                scrollOffset = 0;  // Reset scroll position
+            if (pressed) {
+                navigate(node.select ? (this->*node.select)(0) : node.parent);
             }
-            break;
         }
-        case ENDPOINT: {
-            // Adjust both endpoints simultaneously
-            if(channels[selectedIndex].minEndpoint + direction > 125){
-              return;
-            }
-            channels[selectedIndex].minEndpoint += direction;
-            channels[selectedIndex].maxEndpoint -= direction;
-
-            // Clamp min and max values between 0 and 255
-            if (channels[selectedIndex].minEndpoint < 0) channels[selectedIndex].minEndpoint = 0;
-            if (channels[selectedIndex].maxEndpoint > 255) channels[selectedIndex].maxEndpoint = 255;
-            if (channels[selectedIndex].minEndpoint >= channels[selectedIndex].maxEndpoint) {
-                channels[selectedIndex].maxEndpoint = channels[selectedIndex].maxEndpoint - 1;
-            }
 
-            // Refresh the display
-            displayMenu();
-
-            // Handle button press to go back to the settings menu
-            if (buttonPressed && (currentTime - lastButtonPressTime > buttonTimeout)) {
-                lastButtonPressTime = currentTime;
-                sendEndpoints(selectedIndex);
-                delay(100);
-                menuLevel = CHANNEL_SETTINGS;  // Go back to CHANNEL_SETTINGS
-                loadChannelSettings(selectedIndex);
-                subMenuIndex = 0;
-                scrollOffset = 0;  // Reset scroll position
-            }
-            break;
+        if (changed) {
+            displayMenu();  // Refresh the display after every update
         }
-
-        default:
-            break;
     }
 
-    displayMenu();  // Refresh the display after every update
-}
-
-
     MenuLevel getMenuLevel() const {
         return menuLevel;
     }
@@ -542,10 +570,50 @@ void updateEncoder(int8_t direction, bool buttonPressed) {
         return selectedIndex;
     }
 
+    // Configs are cached on the panel, this only re-fetches the ones that changed
     void loadChannelSettings(int channelIndex){
-      updateChannelValues();
-      updateChannelConfigs(channelIndex);
+      syncChannelConfigs();
     }
 };
 
+// The menu tree, one node per MenuLevel (in enum order)
+const MenuManager::MenuNode MenuManager::menuNodes[MenuManager::menuNodeCount] PROGMEM = {
+    // CHANNEL_LIST
+    { NODE_LIST, 0, CHANNEL_LIST, nullptr,
+      &MenuManager::enterChannelList, &MenuManager::channelListCount, &MenuManager::channelListLabel,
+      &MenuManager::channelListSelect, nullptr, nullptr },
+    // CHANNEL_SETTINGS
+    { NODE_LIST, MENU_BACK_ITEM | MENU_TITLE_CHANNEL, CHANNEL_LIST, menuTitleSettings,
+      &MenuManager::enterChannelSettings, &MenuManager::settingsCount, &MenuManager::settingsLabel,
+      &MenuManager::settingsSelect, nullptr, nullptr },
+    // READ_VALUE
+    { NODE_SCREEN, 0, CHANNEL_SETTINGS, nullptr,
+      nullptr, nullptr, nullptr,
+      nullptr, nullptr, &MenuManager::displayReadValue },
+    // REVERSE
+    { NODE_LIST, MENU_BACK_ITEM | MENU_TITLE_CHANNEL, CHANNEL_SETTINGS, menuTitleReverse,
+      nullptr, &MenuManager::reverseCount, &MenuManager::reverseLabel,
+      &MenuManager::reverseSelect, nullptr, nullptr },
+    // TRIM
+    { NODE_SCREEN, 0, CHANNEL_SETTINGS, nullptr,
+      nullptr, nullptr, nullptr,
+      &MenuManager::trimCommit, &MenuManager::adjustTrim, &MenuManager::displayTrim },
+    // ENDPOINT
+    { NODE_SCREEN, 0, CHANNEL_SETTINGS, nullptr,
+      nullptr, nullptr, nullptr,
+      &MenuManager::endpointCommit, &MenuManager::adjustEndpoint, &MenuManager::displayEndpoint },
+    // SELECT_DEVICE
+    { NODE_LIST, MENU_BACK_ITEM, CHANNEL_SETTINGS, menuTitleDevice,
+      nullptr, &MenuManager::deviceCount, &MenuManager::deviceLabel,
+      &MenuManager::deviceSelect, nullptr, nullptr },
+    // CALIBRATE
+    { NODE_SCREEN, 0, CHANNEL_SETTINGS, nullptr,
+      nullptr, nullptr, nullptr,
+      &MenuManager::calibrateCommit, nullptr, &MenuManager::displayCalibrate },
+    // MONITOR
+    { NODE_SCREEN, 0, CHANNEL_LIST, nullptr,
+      &MenuManager::enterMonitor, nullptr, nullptr,
+      nullptr, &MenuManager::adjustMonitor, &MenuManager::displayMonitor },
+};
+
 #endif
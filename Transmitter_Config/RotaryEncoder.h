@@ -0,0 +1,88 @@
+#ifndef ROTARYENCODER_H
+#define ROTARYENCODER_H
+
+#include <Arduino.h>
+#include <util/atomic.h>
+
+// Quadrature transition table indexed by (previousState << 2) | newState, state = (CLK << 1) | DT.
+// Invalid (double) transitions count as 0. Signs match the old polled decoder (DT == CLK is +1).
+const int8_t encoderTransitions[16] PROGMEM = {
+     0,  1, -1,  0,
+    -1,  0,  0,  1,
+     1,  0,  0, -1,
+     0, -1,  1,  0
+};
+
+// Each detent is one CLK edge, i.e. two quadrature transitions
+const int8_t encoderTransitionsPerDetent = 2;
+
+// State shared with the pin-change interrupt
+volatile uint8_t* encoderPort;
+uint8_t encoderClkMask;
+uint8_t encoderDtMask;
+volatile uint8_t encoderState = 0;
+volatile int16_t encoderTransitionCount = 0;  // Accumulated transitions not yet consumed
+
+// CLK and DT must both be on port B (D8-D13), which shares the PCINT0 vector
+ISR(PCINT0_vect) {
+    uint8_t pins = *encoderPort;
+    uint8_t state = ((pins & encoderClkMask) ? 2 : 0) | ((pins & encoderDtMask) ? 1 : 0);
+    encoderTransitionCount += (int8_t)pgm_read_byte(&encoderTransitions[(encoderState << 2) | state]);
+    encoderState = state;
+}
+
+class RotaryEncoder {
+private:
+    uint8_t clkPin;
+    uint8_t dtPin;
+    unsigned long lastStepTime;  // When detents were last consumed
+    uint8_t acceleration;        // Step multiplier derived from the last turning speed
+
+public:
+    RotaryEncoder(uint8_t clk, uint8_t dt)
+        : clkPin(clk), dtPin(dt), lastStepTime(0), acceleration(1) {}
+
+    void begin() {
+        pinMode(clkPin, INPUT);
+        pinMode(dtPin, INPUT);
+
+        encoderPort = portInputRegister(digitalPinToPort(clkPin));
+        encoderClkMask = digitalPinToBitMask(clkPin);
+        encoderDtMask = digitalPinToBitMask(dtPin);
+        encoderState = ((*encoderPort & encoderClkMask) ? 2 : 0) | ((*encoderPort & encoderDtMask) ? 1 : 0);
+
+        // Enable pin-change interrupts on both pins
+        *digitalPinToPCMSK(clkPin) |= bit(digitalPinToPCMSKbit(clkPin));
+        *digitalPinToPCMSK(dtPin) |= bit(digitalPinToPCMSKbit(dtPin));
+        *digitalPinToPCICR(clkPin) |= bit(digitalPinToPCICRbit(clkPin));
+    }
+
+    // Consume the whole detents accumulated since the last call, keeping any partial detent
+    int8_t read() {
+        int16_t detents;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            detents = encoderTransitionCount / encoderTransitionsPerDetent;
+            encoderTransitionCount -= detents * encoderTransitionsPerDetent;
+        }
+        detents = constrain(detents, -127, 127);
+
+        if (detents != 0) {
+            unsigned long currentTime = millis();
+            unsigned long interval = (currentTime - lastStepTime) / abs(detents);  // ms per detent
+            lastStepTime = currentTime;
+
+            if (interval < 10) acceleration = 8;
+            else if (interval < 25) acceleration = 4;
+            else if (interval < 50) acceleration = 2;
+            else acceleration = 1;
+        }
+        return detents;
+    }
+
+    // Multiplier for value editors, so long ranges like trim can be crossed quickly
+    uint8_t getAcceleration() const {
+        return acceleration;
+    }
+};
+
+#endif
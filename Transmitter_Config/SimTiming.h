@@ -0,0 +1,61 @@
+#ifndef SIM_TIMING_H
+#define SIM_TIMING_H
+
+#ifdef SIM_TIMING
+
+// Timing script for the emulator build (tools/avr_timing.py). Runs once at the end of
+// setup(): every menu screen is rendered a few times and its worst cycle count reported,
+// with the default channels (no transmitter in the emulator). The display is the
+// MenuDisplay stand-in, so the cycles leave out the I2C transfers; lcdBytes gives the
+// bytes a screen sends the real display.
+
+const char timingLevel0[] PROGMEM = "list";
+const char timingLevel1[] PROGMEM = "settings";
+const char timingLevel2[] PROGMEM = "readValue";
+const char timingLevel3[] PROGMEM = "reverse";
+const char timingLevel4[] PROGMEM = "trim";
+const char timingLevel5[] PROGMEM = "endpoint";
+const char timingLevel6[] PROGMEM = "device";
+const char timingLevel7[] PROGMEM = "calibrate";
+const char timingLevel8[] PROGMEM = "monitor";
+
+const char* const timingLevels[] PROGMEM = {
+    timingLevel0, timingLevel1, timingLevel2, timingLevel3, timingLevel4,
+    timingLevel5, timingLevel6, timingLevel7, timingLevel8
+};
+
+static_assert(sizeof(timingLevels) / sizeof(timingLevels[0]) == MONITOR + 1, "One name per MenuLevel");
+
+void runTimingScript() {
+    startCycleCounter();
+
+    // displayMenu() per MenuLevel, with the refresh interval already passed
+    for (uint8_t level = CHANNEL_LIST; level <= MONITOR; level++) {
+        char name[12];
+        strncpy_P(name, (PGM_P)pgm_read_word(&timingLevels[level]), sizeof(name));
+        menu.menuLevel = (MenuLevel)level;
+        reportTiming(F("displayMenu"), name, worstCycles([] {
+            menu.lastUpdateTime = millis() - MenuManager::updateInterval;
+            menu.displayMenu();
+        }));
+        lcd.bytesSent = 0;
+        menu.lastUpdateTime = millis() - MenuManager::updateInterval;
+        menu.displayMenu();
+        reportTiming(F("lcdBytes"), name, lcd.bytesSent);
+    }
+
+    // Monitor refresh with every bar changing (worst case) and with nothing to redraw
+    reportTiming(F("refreshMonitor"), "changed", worstCycles([] {
+        memset(menu.monitorLevels, MenuManager::monitorNoLevel, sizeof(menu.monitorLevels));
+        menu.refreshMonitor();
+    }));
+    reportTiming(F("refreshMonitor"), "unchanged", worstCycles([] { menu.refreshMonitor(); }));
+
+    menu.menuLevel = CHANNEL_LIST;
+    reportTiming(F("unusedStack"), unusedStack());
+    reportTiming(F("done"), 0);
+}
+
+#endif // SIM_TIMING
+
+#endif
@@ -7,17 +7,26 @@
 // Global variable to track the last update time
 unsigned long lastUpdateTime = 0;
 
+// The monitor only redraws changed cells, so it can refresh at 20 Hz
+const unsigned long timedUpdateInterval = 200;
+const unsigned long monitorUpdateInterval = 50;
+
 // Function to handle timed updates
 void handleTimedUpdates(MenuManager& menu) {
     unsigned long currentTime = millis();
+    unsigned long interval = (menu.getMenuLevel() == MONITOR) ? monitorUpdateInterval : timedUpdateInterval;
 
-    // Check if 100 ms have passed since the last update
-    if (currentTime - lastUpdateTime >= 200) {
+    // Check if the interval has passed since the last update
+    if (currentTime - lastUpdateTime >= interval) {
         switch(menu.getMenuLevel()){
           case READ_VALUE:
               updateChannelValues();
               menu.displayMenu();  // Update the display
               break;
+          case MONITOR:
+              updateChannelValues();  // One "X" request fetches every channel
+              menu.refreshMonitor();
+              break;
           // case CHANNEL_LIST:
           //     displayChannelList();
           //     break;
@@ -30,7 +39,7 @@ void handleTimedUpdates(MenuManager& menu) {
           case CALIBRATE:
               updateAnalogValue(menu.getSelectedIndex());
               channels[menu.getSelectedIndex()].calibrationLoop();
-              menu.displayCalibrate();
+              menu.displayMenu();
               break;
           // case TRIM:
           //     displayTrim();
@@ -1,9 +1,11 @@
 #include <Wire.h>
-#include <LiquidCrystal_I2C.h>
+#include <RCTiming.h>
 #include "Definitions.h"
 #include "Channel.h"
 #include "CommunicationMaster.h"
+#include "MenuDisplay.h"
 #include "MenuManager.h"
+#include "RotaryEncoder.h"
 #include "TimedUpdateHandler.h"
 
 // Rotary Encoder Pins
@@ -15,17 +17,16 @@
 #define BUZZER_PIN 10  // Pin 10 connected to the buzzer
 
 // LCD Initialization
-LiquidCrystal_I2C lcd(0x27, 20, 4);
+MenuDisplay lcd(0x27, 20, 4);
 
 // Menu Setup
-Channel channels[] = {
-    Channel(1), Channel(2), Channel(3), Channel(4), Channel(5),
-    Channel(6), Channel(7), Channel(8), Channel(9), Channel(10)
-};
-MenuManager menu(&lcd, channels, 10);
+Channel channels[RC_CHANNEL_COUNT];
+MenuManager menu(&lcd, channels, RC_CHANNEL_COUNT);
+
+#include "SimTiming.h"
 
 // Encoder Variables
-int lastStateCLK;
+RotaryEncoder encoder(CLK, DT);
 int lastButtonState;
 unsigned long lastDebounceTime = 0;
 const unsigned long debounceDelay = 50;
@@ -43,7 +44,7 @@ const byte customChars[8][8] PROGMEM = {
 };
 
 // Load custom characters from PROGMEM to the LCD
-void setupCustomCharacters(LiquidCrystal_I2C &lcd) {
+void setupCustomCharacters(MenuDisplay &lcd) {
     for (uint8_t i = 0; i < 8; i++) {
         byte buffer[8];
         for (uint8_t j = 0; j < 8; j++) {
@@ -54,11 +55,12 @@ void setupCustomCharacters(LiquidCrystal_I2C &lcd) {
 }
 
 void setup() {
-  Serial.begin(9600);  // Initialize Serial
-  delay(1000);
-  Serial.println(F("Setup Complete?"));
+  Serial.begin(defaultBaudRate);  // Initialize Serial
 
   // Initialize channel names
+  for (uint8_t i = 0; i < RC_CHANNEL_COUNT; i++) {
+    channels[i] = Channel(i + 1);
+  }
   channels[0].setName("Throttle");
   channels[1].setName("Rudder");
   channels[2].setName("Elevator");
@@ -66,8 +68,6 @@ void setup() {
   channels[4].setName("Flaps");
 
   // Initialize pins
-  pinMode(CLK, INPUT);
-  pinMode(DT, INPUT);
   pinMode(SW, INPUT_PULLUP);
   pinMode(BUZZER_PIN, OUTPUT);  // Set buzzer pin as output
 
@@ -76,42 +76,53 @@ void setup() {
   lcd.backlight();
   setupCustomCharacters(lcd);
 
-  // Initialize encoder state
-  lastStateCLK = digitalRead(CLK);
+  // Initialize encoder state, rotation is decoded by the pin-change interrupt
+  encoder.begin();
   lastButtonState = digitalRead(SW);
 
+#ifdef SIM_TIMING
+  // No transmitter in the emulator, time the menu with the default channels
+  runTimingScript();
+  return;
+#endif
+
+  // Start as soon as the transmitter answers. Configs are read in place, so both
+  // sketches must be built from the same schema.
+  if (waitForTransmitter() && !schemaCompatible) {
+    lcd.setCursor(0, 0);
+    lcd.print(F("Schema mismatch!"));
+    lcd.setCursor(0, 1);
+    lcd.print(F("Update both boards"));
+    delay(3000);
+  }
+
+  // Move the transmitter link to the fastest rate that passes the echo test
+  negotiateBaudRate();
+
+  // Fill the channel config cache
+  syncChannelConfigs();
+
   // Display the initial menu
   menu.displayMenu();
 }
 
 void loop() {
+  serviceSerialLink();
   handleEncoder();
   handleTimedUpdates(menu);
   menu.handleMissedUpdates();
 }
 
 void handleEncoder() {
-  int currentStateCLK = digitalRead(CLK);
   int currentButtonState = digitalRead(SW);
-  int direction = 0;
   bool buttonPressed = false;
 
-  // Handle rotation
-  if (currentStateCLK != lastStateCLK) {
-    if (millis() - lastDebounceTime > debounceDelay) {
-      // Reverse the direction by flipping the comparison
-      if (digitalRead(DT) == currentStateCLK) { // Swapped condition
-        direction = 1; // CW (Reversed to CCW)
-      } else {
-        direction = -1; // CCW (Reversed to CW)
-      }
-      lastDebounceTime = millis();
-      tone(BUZZER_PIN, 1700, 10);  // Play buzzer sound (1700 Hz, 10 ms)
-    }
+  // Handle rotation: consume every detent accumulated by the interrupt since the last call
+  int8_t direction = encoder.read();
+  if (direction != 0) {
+    tone(BUZZER_PIN, 1700, 10);  // Play buzzer sound (1700 Hz, 10 ms)
   }
 
-  lastStateCLK = currentStateCLK;
-
   // Handle button press
   if (currentButtonState != lastButtonState) {
     if (millis() - lastDebounceTime > debounceDelay) {
@@ -127,6 +138,6 @@ void handleEncoder() {
 
   // Update the menu manager
   if (direction != 0 || buttonPressed) {
-    menu.updateEncoder(direction, buttonPressed);
+    menu.updateEncoder(direction, buttonPressed, encoder.getAcceleration());
   }
 }
\ No newline at end of file
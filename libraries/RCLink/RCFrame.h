@@ -0,0 +1,234 @@
+#ifndef RC_FRAME_H
+#define RC_FRAME_H
+
+#include <Arduino.h>
+#include <RCLink.h>
+
+// Radio frame codec (RadioFrame layout in RCLink.h). Each channel has a rate class:
+// channels sent every frame go into the fixed part, the others share the slots behind it.
+// Only due channels (changed, or at the end of their interval) get a slot, the most
+// overdue first so an overloaded mix degrades evenly instead of starving one channel.
+// The frame ends after the last slot: with nothing due it is just the header and the
+// fixed part, the receiver takes the length from the dynamic payload.
+//
+// Delta mode (a keyframe interval other than 0) sends a keyframe with every channel every
+// interval frames and, in between, only the channels that differ from that keyframe.
+// Rate classes do not apply, every change goes out in the next frame. A receiver that
+// missed the keyframe drops the deltas based on it until the next one arrives.
+
+enum RateClass : uint8_t {
+    RATE_EVERY_FRAME,   // Fixed part of every frame (sticks)
+    RATE_EVERY_4TH,     // A slot at least every 4th frame
+    RATE_ON_CHANGE,     // A slot as soon as it changes, refreshed every RATE_REFRESH_FRAMES
+    RATE_CLASSES
+};
+
+const uint8_t RATE_SLOW_FRAMES = 4;
+const uint8_t RATE_REFRESH_FRAMES = 20;   // 100 ms at the 5 ms frame period
+
+const uint8_t DELTA_MODE_OFF = 0;         // Keyframe interval of regular frames
+
+class FrameEncoder {
+public:
+    FrameEncoder() {
+        restart(0);
+    }
+
+    // Send every channel again as soon as possible, e.g. for another model
+    void restart(uint8_t modelId) {
+        model = modelId;
+        memset(since, 0xFF, sizeof(since));
+        memset(sent, 0, sizeof(sent));
+        sinceKey = 0xFF;
+    }
+
+    // Build the frame for the current channel values, returns its length. timed leaves
+    // the last two bytes for stampFrame().
+    uint8_t encode(const ChannelValues& values, const uint8_t* rateClass, uint8_t keyframeInterval,
+                   RadioFrame& frame, bool timed = false) {
+        if (values.modelId != model) restart(values.modelId);
+
+        frame.modelId = values.modelId;
+        frame.layout = timed ? RC_FRAME_TIMED : 0;
+        uint8_t* out = keyframeInterval == DELTA_MODE_OFF ? encodeSlots(values, rateClass, frame, timed)
+                                                         : encodeDelta(values, keyframeInterval, frame);
+        return (out - frame.data) + RC_FRAME_HEADER_SIZE + (timed ? sizeof(uint16_t) : 0);
+    }
+
+private:
+    uint8_t model;
+    uint8_t since[RC_CHANNEL_COUNT];   // Frames since the channel was last sent, saturating
+    uint8_t sent[RC_CHANNEL_COUNT];    // Value last sent
+    uint8_t key[RC_CHANNEL_COUNT];     // Delta mode: values of the last keyframe
+    uint8_t keySequence;
+    uint8_t sinceKey;                  // Frames since the last keyframe, saturating
+
+    bool isDue(uint8_t channel, uint8_t rate, uint8_t value) const {
+        if (rate == RATE_ON_CHANGE) {
+            return value != sent[channel] || since[channel] >= RATE_REFRESH_FRAMES;
+        }
+        return since[channel] >= RATE_SLOW_FRAMES;
+    }
+
+    uint8_t* encodeSlots(const ChannelValues& values, const uint8_t* rateClass, RadioFrame& frame, bool timed) {
+        uint8_t* out = frame.data;
+        uint8_t* end = frame.data + sizeof(frame.data) - (timed ? sizeof(uint16_t) : 0);
+
+        for (uint8_t i = 0; i < RC_CHANNEL_COUNT; ++i) {
+            if (since[i] != 0xFF) since[i]++;
+            if (rateClass[i] == RATE_EVERY_FRAME) {
+                frame.layout |= 1u << i;
+                *out++ = values.values[i];
+                since[i] = 0;
+            }
+        }
+
+        while (out + 2 <= end) {
+            uint8_t channel = RC_FRAME_EMPTY_SLOT;
+            for (uint8_t i = 0; i < RC_CHANNEL_COUNT; ++i) {
+                if (since[i] == 0) continue;  // In this frame already
+                if (!isDue(i, rateClass[i], values.values[i])) continue;
+                if (channel == RC_FRAME_EMPTY_SLOT || since[i] > since[channel]) channel = i;
+            }
+            if (channel == RC_FRAME_EMPTY_SLOT) break;  // Nothing else is due
+
+            *out++ = channel;
+            *out++ = values.values[channel];
+            sent[channel] = values.values[channel];
+            since[channel] = 0;
+        }
+        return out;
+    }
+
+    uint8_t* encodeDelta(const ChannelValues& values, uint8_t keyframeInterval, RadioFrame& frame) {
+        if (sinceKey != 0xFF) sinceKey++;
+
+        // A difference beyond int8 can only go out in a keyframe
+        bool keyframe = sinceKey >= keyframeInterval;
+        bool nibbles = true;
+        for (uint8_t i = 0; i < RC_CHANNEL_COUNT && !keyframe; ++i) {
+            int16_t delta = values.values[i] - key[i];
+            keyframe = delta < -128 || delta > 127;
+            nibbles = nibbles && delta >= -8 && delta <= 7;
+        }
+
+        uint8_t* out = frame.data;
+        if (keyframe) {
+            frame.layout |= RC_FRAME_KEY | ((1u << RC_CHANNEL_COUNT) - 1);
+            *out++ = ++keySequence;
+            memcpy(out, values.values, RC_CHANNEL_COUNT);
+            memcpy(key, values.values, RC_CHANNEL_COUNT);
+            sinceKey = 0;
+            return out + RC_CHANNEL_COUNT;
+        }
+
+        frame.layout |= RC_FRAME_DELTA | (nibbles ? RC_FRAME_NIBBLES : 0);
+        *out++ = keySequence;
+        bool highNibble = false;
+        for (uint8_t i = 0; i < RC_CHANNEL_COUNT; ++i) {
+            int8_t delta = values.values[i] - key[i];
+            if (delta == 0) continue;
+            frame.layout |= 1u << i;
+            if (!nibbles) {
+                *out++ = delta;
+            } else if (highNibble) {
+                out[-1] |= delta << 4;
+            } else {
+                *out++ = delta & 0x0F;
+            }
+            highNibble = nibbles && !highNibble;
+        }
+        return out;
+    }
+};
+
+// Put the input sample age into a frame encoded with timed set
+inline void stampFrame(RadioFrame& frame, uint8_t length, uint16_t sampleAge) {
+    memcpy((uint8_t*)&frame + length - sizeof(sampleAge), &sampleAge, sizeof(sampleAge));
+}
+
+inline uint16_t readSampleAge(const RadioFrame& frame, uint8_t length) {
+    uint16_t sampleAge;
+    memcpy(&sampleAge, (const uint8_t*)&frame + length - sizeof(sampleAge), sizeof(sampleAge));
+    return sampleAge;
+}
+
+// Rebuilds the receiver's channel state from the frames. Channels a regular frame does not
+// carry keep their last value, delta frames apply to the keyframe they are based on.
+class FrameDecoder {
+public:
+    FrameDecoder() : haveKey(false) {}
+
+    // Forget the keyframe after a loss of signal: a restarted transmitter numbers its
+    // keyframes from the start again
+    void reset() {
+        haveKey = false;
+    }
+
+    // Apply a frame of length bytes, false if it is malformed, a config message or based on
+    // a keyframe this receiver does not hold (state is unchanged then)
+    bool decode(const RadioFrame& frame, uint8_t length, ChannelValues& state) {
+        if (frame.layout & RC_FRAME_CONFIG) return false;  // Not channel data
+        uint8_t tail = (frame.layout & RC_FRAME_TIMED) ? sizeof(uint16_t) : 0;
+        if (length > RC_FRAME_SIZE || length < RC_FRAME_HEADER_SIZE + tail) return false;
+        const uint8_t* in = frame.data;
+        const uint8_t* end = (const uint8_t*)&frame + length - tail;
+        uint16_t channels = frame.layout & RC_FRAME_CHANNELS;
+
+        if (frame.layout & RC_FRAME_KEY) {
+            if (end - in != 1 + RC_CHANNEL_COUNT) return false;
+            keySequence = *in++;
+            memcpy(key, in, RC_CHANNEL_COUNT);
+            haveKey = true;
+            memcpy(state.values, key, RC_CHANNEL_COUNT);
+        } else if (frame.layout & RC_FRAME_DELTA) {
+            if (in == end || !haveKey || *in++ != keySequence) return false;
+            bool nibbles = frame.layout & RC_FRAME_NIBBLES;
+            uint8_t count = 0;
+            for (uint8_t i = 0; i < RC_CHANNEL_COUNT; ++i) {
+                if (channels & (1u << i)) count++;
+            }
+            if (end - in != (nibbles ? (count + 1) / 2 : count)) return false;
+
+            bool highNibble = false;
+            for (uint8_t i = 0; i < RC_CHANNEL_COUNT; ++i) {
+                int8_t delta = 0;
+                if (channels & (1u << i)) {
+                    if (!nibbles) {
+                        delta = *in++;
+                    } else if (highNibble) {
+                        delta = (int8_t)in[-1] >> 4;
+                    } else {
+                        delta = (int8_t)(*in++ << 4) >> 4;  // Sign-extend the low nibble
+                    }
+                    highNibble = nibbles && !highNibble;
+                }
+                state.values[i] = key[i] + delta;
+            }
+        } else {
+            uint8_t fixed = 0;
+            for (uint8_t i = 0; i < RC_CHANNEL_COUNT; ++i) {
+                if (channels & (1u << i)) fixed++;
+            }
+            if (end - in < fixed) return false;
+
+            for (uint8_t i = 0; i < RC_CHANNEL_COUNT; ++i) {
+                if (channels & (1u << i)) state.values[i] = *in++;
+            }
+            while (in + 2 <= end) {
+                uint8_t channel = *in++;
+                uint8_t value = *in++;
+                if (channel < RC_CHANNEL_COUNT) state.values[channel] = value;
+            }
+        }
+        state.modelId = frame.modelId;
+        return true;
+    }
+
+private:
+    uint8_t key[RC_CHANNEL_COUNT];
+    uint8_t keySequence;
+    bool haveKey;
+};
+
+#endif // RC_FRAME_H
@@ -0,0 +1,73 @@
+#ifndef RC_LATENCY_H
+#define RC_LATENCY_H
+
+#include <Arduino.h>
+
+// Latency statistics for the RC_LATENCY measurement mode: samples go into a fixed
+// histogram, so percentiles cost no sorting and RAM stays constant. Percentiles are the
+// upper edge of their bucket, the maximum is exact.
+
+#ifdef RC_LATENCY
+
+const uint8_t LATENCY_BUCKETS = 64;   // The last bucket also holds everything beyond
+
+class LatencyStats {
+public:
+    explicit LatencyStats(uint16_t bucketMicros) : bucketMicros(bucketMicros) {
+        reset();
+    }
+
+    void reset() {
+        memset(buckets, 0, sizeof(buckets));
+        count = 0;
+        maxMicros = 0;
+    }
+
+    void add(uint32_t latency) {
+        uint32_t bucket = latency / bucketMicros;
+        if (bucket >= LATENCY_BUCKETS) bucket = LATENCY_BUCKETS - 1;
+        if (buckets[bucket] != 0xFFFF) buckets[bucket]++;
+        if (count != 0xFFFFFFFF) count++;
+        if (latency > maxMicros) maxMicros = latency;
+    }
+
+    // Smallest latency that percent of the samples stay within
+    uint32_t percentile(uint8_t percent) const {
+        uint32_t total = 0;
+        for (uint8_t i = 0; i < LATENCY_BUCKETS; ++i) total += buckets[i];
+        uint32_t target = (total * percent + 99) / 100;
+        uint32_t seen = 0;
+        for (uint8_t i = 0; i < LATENCY_BUCKETS; ++i) {
+            seen += buckets[i];
+            if (seen >= target && seen > 0) {
+                return i == LATENCY_BUCKETS - 1 ? maxMicros : (uint32_t)(i + 1) * bucketMicros;
+            }
+        }
+        return 0;
+    }
+
+    // One text line: "<name> n=<count> p50=<us> p90=<us> p99=<us> max=<us>"
+    void report(Print& out, const __FlashStringHelper* name) const {
+        out.print(name);
+        out.print(F(" n="));
+        out.print(count);
+        out.print(F(" p50="));
+        out.print(percentile(50));
+        out.print(F(" p90="));
+        out.print(percentile(90));
+        out.print(F(" p99="));
+        out.print(percentile(99));
+        out.print(F(" max="));
+        out.println(maxMicros);
+    }
+
+private:
+    uint16_t bucketMicros;
+    uint16_t buckets[LATENCY_BUCKETS];
+    uint32_t count;
+    uint32_t maxMicros;
+};
+
+#endif // RC_LATENCY
+
+#endif // RC_LATENCY_H
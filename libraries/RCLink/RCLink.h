@@ -0,0 +1,146 @@
+#ifndef RC_LINK_H
+#define RC_LINK_H
+
+#include <Arduino.h>
+
+// Definitions shared by the transmitter, the receiver and the config panel. Keep this
+// library in the sketchbook's libraries folder so all three sketches build against the
+// same copy.
+
+// Number of RC channels carried from the sticks to the servos. Every channel array,
+// loop and payload in the three sketches is sized from this constant.
+const uint8_t RC_CHANNEL_COUNT = 10;
+
+// Channel state: the sending model followed by one byte (0-255) per channel. This is what
+// the transmitter computes every frame and the receiver rebuilds from the radio frames
+// ("X" reply, trace records). Receivers drop frames of any model other than their own.
+struct ChannelValues {
+    uint8_t modelId;
+    uint8_t values[RC_CHANNEL_COUNT];
+};
+
+// Radio payload (RCFrame.h encodes and decodes it), sent with a dynamic payload length of
+// up to RC_FRAME_SIZE bytes: the model, a layout word with one bit per channel and flags
+// above them, then the channel data.
+// - Regular frames: one value per marked channel, in channel order, followed by (channel,
+//   value) slot pairs for those of the slower channels that are due. The frame ends after
+//   the last slot, decoders skip a slot for channel RC_FRAME_EMPTY_SLOT.
+// - RC_FRAME_KEY (delta mode): a keyframe sequence number, then every channel's value.
+// - RC_FRAME_DELTA: the sequence number of the keyframe it is based on, then the signed
+//   difference to that keyframe of each marked channel, one int8 each or, with
+//   RC_FRAME_NIBBLES, two 4-bit differences per byte (low nibble first).
+// - RC_FRAME_CONFIG: a receiver configuration message (below), the only frames sent with
+//   an ack request.
+// With RC_FRAME_TIMED the last two bytes are the age of the frame's input sample
+// (RC_LATENCY builds), receivers built without RC_LATENCY skip them.
+const uint8_t RC_FRAME_SIZE = 16;            // Largest payload
+const uint8_t RC_FRAME_HEADER_SIZE = 3;
+const uint16_t RC_FRAME_TIMED = 0x8000;      // Layout flags
+const uint16_t RC_FRAME_KEY = 0x4000;
+const uint16_t RC_FRAME_DELTA = 0x2000;
+const uint16_t RC_FRAME_NIBBLES = 0x1000;
+const uint16_t RC_FRAME_CONFIG = 0x0800;
+const uint16_t RC_FRAME_CHANNELS = 0x07FF;   // Channel bits of the layout word
+const uint8_t RC_FRAME_EMPTY_SLOT = 0xFF;
+
+struct __attribute__((packed)) RadioFrame {
+    uint8_t modelId;
+    uint16_t layout;
+    uint8_t data[RC_FRAME_SIZE - RC_FRAME_HEADER_SIZE];
+};
+
+static_assert(sizeof(RadioFrame) == RC_FRAME_SIZE, "RadioFrame has padding");
+static_assert(RC_CHANNEL_COUNT <= 11, "The frame layout word has one bit per channel below the flags");
+static_assert(RC_CHANNEL_COUNT + 6 <= RC_FRAME_SIZE, "A keyframe and every rate class mix must fit with the sample age");
+
+// Time on the air of a frame of length bytes at 250 kbps: preamble, address, packet
+// control field, payload and CRC, plus the 130 us PLL settling (tools/link_sim.py uses the
+// same model)
+constexpr uint16_t rcFrameAirtime(uint8_t length) {
+    return 130 + (8 * (1 + 5 + length + 2) + 9) * 4;
+}
+
+// Receiver configuration over the air. The transmitter sends a ReceiverConfig in config
+// frames, each acknowledged by the receiver's radio and retried until it is:
+//   data[0] message sequence number, data[1] RC_CONFIG_* operation or an offset into the
+//   ReceiverConfig followed by up to RC_CONFIG_CHUNK bytes of it.
+// RC_CONFIG_COMMIT carries the CRC-16 of the whole ReceiverConfig: the receiver checks
+// and applies the collected config and stores it. The radio acks carry a ReceiverStatus
+// as payload, the status after the last config message the receiver processed.
+const uint8_t RC_CONFIG_CHUNK = RC_FRAME_SIZE - RC_FRAME_HEADER_SIZE - 2;
+const uint8_t RC_CONFIG_COMMIT = 0xFF;
+const uint8_t RC_CONFIG_STATUS = 0xFE;       // Only fetches the status of the previous message
+
+enum ReceiverConfigResult : uint8_t {
+    RC_CONFIG_NONE,       // No config message since the receiver started
+    RC_CONFIG_STORED,     // Chunk collected
+    RC_CONFIG_APPLIED,    // Commit checked, config applied and being saved
+    RC_CONFIG_REJECTED    // Commit CRC mismatch or invalid config, the old one stays
+};
+
+struct __attribute__((packed)) ReceiverStatus {
+    uint8_t sequence;     // Of the last config message processed
+    uint8_t result;       // ReceiverConfigResult
+    uint16_t configCrc;   // CRC-16 of the active config
+};
+
+// ---- Protocol schema ----
+//
+// Structs below travel as raw bytes over the serial link (and live in EEPROM), so both
+// boards decode them in place. Layouts are packed, little-endian (multi-byte fields LSB
+// first) and checked at compile time. extras/generate_protocol.py reads the field lists
+// in this file to generate the Python decoder (rc_protocol.py); regenerate it and bump
+// RC_SCHEMA_VERSION whenever a list changes.
+
+const uint8_t RC_SCHEMA_VERSION = 3;   // Reported by the transmitter's "H" command
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "Protocol structs are little-endian");
+
+// Channel configuration, X(type, name, Python struct format)
+#define RC_CHANNEL_CONFIG_FIELDS(X) \
+    X(uint8_t, version,       'B')  /* Configuration version */ \
+    X(char,    deviceType,    'c')  /* Device type ('J', 'A', 'S', 'D', 'E', 'B') */ \
+    X(uint8_t, deviceId,      'B')  /* Device ID */ \
+    X(bool,    reverse,       '?')  /* Channel reversing */ \
+    X(int8_t,  trim,          'b')  /* Trim adjustment */ \
+    X(int16_t, analogReadMin, 'h')  /* Minimum analog read value */ \
+    X(int16_t, analogReadMax, 'h')  /* Maximum analog read value */ \
+    X(uint8_t, minEndpoint,   'B')  /* Minimum endpoint */ \
+    X(uint8_t, maxEndpoint,   'B')  /* Maximum endpoint */ \
+    X(uint8_t, centerPoint,   'B')  /* Center point adjustment */
+
+#define RC_SCHEMA_FIELD(type, name, format) type name;
+#define RC_SCHEMA_FIELD_SIZE(type, name, format) + sizeof(type)
+
+struct __attribute__((packed)) ChannelConfig {
+    RC_CHANNEL_CONFIG_FIELDS(RC_SCHEMA_FIELD)
+};
+
+const uint8_t RC_CHANNEL_CONFIG_SIZE = 12;  // Bytes on the wire ("C" reply)
+
+static_assert(sizeof(ChannelConfig) == 0 RC_CHANNEL_CONFIG_FIELDS(RC_SCHEMA_FIELD_SIZE), "ChannelConfig has padding");
+static_assert(sizeof(ChannelConfig) == RC_CHANNEL_CONFIG_SIZE, "ChannelConfig wire size changed");
+static_assert(sizeof(bool) == 1 && sizeof(char) == 1, "Unexpected field widths");
+
+// Receiver configuration, set over the air ("JR=" on the transmitter, tools/rx_config.py)
+// and stored in the receiver's EEPROM. The Python side packs it with the format in
+// tools/rx_config.py, checked against RC_RECEIVER_CONFIG_SIZE.
+const uint8_t RC_RECEIVER_CONFIG_VERSION = 1;
+const uint8_t RC_NO_OUTPUT = 0xFF;           // servoPins entry of a channel without output
+
+struct __attribute__((packed)) ReceiverConfig {
+    uint8_t version;
+    uint8_t modelId;                         // Transmitter model slot the receiver follows
+    uint8_t servoPins[RC_CHANNEL_COUNT];     // Output pin of each channel or RC_NO_OUTPUT
+    uint8_t failsafe[RC_CHANNEL_COUNT];      // Values after a loss of signal
+    uint16_t pulseMinMicros;                 // Pulse width of value 0
+    uint16_t pulseMaxMicros;                 // Pulse width of value 255
+    uint16_t failsafeMillis;                 // Signal loss before the failsafe values
+};
+
+const uint8_t RC_RECEIVER_CONFIG_SIZE = 28;
+
+static_assert(sizeof(ReceiverConfig) == RC_RECEIVER_CONFIG_SIZE, "ReceiverConfig wire size changed");
+static_assert(sizeof(ReceiverConfig) < RC_CONFIG_STATUS, "Config offsets must stay below the operations");
+
+#endif // RC_LINK_H
@@ -0,0 +1,117 @@
+#ifndef RC_PROFILER_H
+#define RC_PROFILER_H
+
+#include <Arduino.h>
+
+// Scoped hot-path probes. With RC_PROFILE defined, PROFILE_SCOPE(stage) times the rest
+// of the enclosing block with micros() and adds it to that stage's histogram; without
+// it the macro expands to nothing and no code or RAM is used.
+//
+// A sketch lists its stages in an enum, defines the stage names and budgets in PROGMEM
+// and one global "profiler" (see the transmitter's DataDefinitions.h).
+// tools/profile_decode.py requests and decodes the report.
+
+#ifdef RC_PROFILE
+
+const uint8_t PROFILE_FORMAT_VERSION = 1;
+
+// Buckets by power of two: < 16 us, < 32 us, ... < 4096 us, >= 4096 us
+const uint8_t PROFILE_BUCKETS = 10;
+const uint16_t PROFILE_NO_BUDGET = 0xFFFF;
+
+// Per-stage statistics, counters saturate instead of wrapping
+struct ProfileStats {
+    uint16_t count;
+    uint16_t buckets[PROFILE_BUCKETS];
+    uint16_t maxMicros;
+    uint16_t overruns;    // Samples longer than the stage's budget
+};
+
+class Profiler {
+public:
+    // names: PROGMEM strings, budgets: PROGMEM microseconds (PROFILE_NO_BUDGET for none)
+    Profiler(ProfileStats* stats, uint8_t stageCount, const char* const* names, const uint16_t* budgets)
+        : stats(stats), stageCount(stageCount), names(names), budgets(budgets) {
+        reset();
+    }
+
+    void reset() {
+        memset(stats, 0, sizeof(ProfileStats) * stageCount);
+    }
+
+    void record(uint8_t stage, uint16_t elapsed) {
+        ProfileStats& s = stats[stage];
+        increment(s.count);
+        increment(s.buckets[bucketOf(elapsed)]);
+        if (elapsed > s.maxMicros) s.maxMicros = elapsed;
+        if (elapsed > pgm_read_word(&budgets[stage])) increment(s.overruns);
+    }
+
+    // Binary report, all integers little-endian: format version, stage count, bucket
+    // count, then per stage its NUL-terminated name, budget, count, buckets, max and
+    // overruns (uint16 each)
+    void report(Print& out) const {
+        out.write(PROFILE_FORMAT_VERSION);
+        out.write(stageCount);
+        out.write(PROFILE_BUCKETS);
+        for (uint8_t stage = 0; stage < stageCount; ++stage) {
+            out.print((const __FlashStringHelper*)pgm_read_word(&names[stage]));
+            out.write((uint8_t)0);
+            uint16_t budget = pgm_read_word(&budgets[stage]);
+            out.write((const uint8_t*)&budget, sizeof(budget));
+            out.write((const uint8_t*)&stats[stage], sizeof(ProfileStats));
+        }
+    }
+
+private:
+    ProfileStats* stats;
+    uint8_t stageCount;
+    const char* const* names;
+    const uint16_t* budgets;
+
+    static void increment(uint16_t& counter) {
+        if (counter != 0xFFFF) counter++;
+    }
+
+    static uint8_t bucketOf(uint16_t elapsed) {
+        uint8_t bucket = 0;
+        elapsed >>= 4;
+        while (elapsed && bucket < PROFILE_BUCKETS - 1) {
+            elapsed >>= 1;
+            bucket++;
+        }
+        return bucket;
+    }
+};
+
+extern Profiler profiler;
+
+class ProfileScope {
+public:
+    explicit ProfileScope(uint8_t stage) : stage(stage), start(micros()) {}
+    ~ProfileScope() { profiler.record(stage, min(micros() - start, 0xFFFFUL)); }
+
+private:
+    uint8_t stage;
+    unsigned long start;
+};
+
+// For sketches without a command parser: a 'P' byte waiting on port asks for the report
+inline void serviceProfileRequest(Stream& port) {
+    if (port.available() > 0 && port.peek() == 'P') {
+        port.read();
+        profiler.report(port);
+    }
+}
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(stage) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(stage)
+
+#else
+
+#define PROFILE_SCOPE(stage)
+
+#endif // RC_PROFILE
+
+#endif // RC_PROFILER_H
@@ -0,0 +1,82 @@
+#include "RCTiming.h"
+
+extern uint8_t _end;       // End of .bss, start of the heap
+extern uint8_t __stack;    // Top of RAM
+extern char* __brkval;     // Top of the heap, 0 while malloc was never used
+
+// Fill _end..__stack with the canary. A naked .init3 function has no prologue and no stack
+// frame yet, so the loop is written in assembly (the avr-libc stack paint idiom) instead
+// of C the compiler might give a frame. Naked functions may only hold basic asm, hence
+// the literal canary.
+static_assert(STACK_CANARY == 0xC5, "paintStack() writes 0xC5");
+
+void paintStack() __attribute__((naked, used, section(".init3")));
+void paintStack() {
+    __asm volatile(
+        "    ldi r30, lo8(_end)\n"
+        "    ldi r31, hi8(_end)\n"
+        "    ldi r24, 0xC5\n"
+        "    ldi r25, hi8(__stack)\n"
+        "    rjmp 2f\n"
+        "1:  st Z+, r24\n"
+        "2:  cpi r30, lo8(__stack)\n"
+        "    cpc r31, r25\n"
+        "    brlo 1b\n"
+        "    breq 1b\n");
+}
+
+uint16_t unusedStack() {
+    const uint8_t* p = __brkval ? (const uint8_t*)__brkval : &_end;
+    uint16_t count = 0;
+    while (p <= &__stack && *p == STACK_CANARY) {
+        p++;
+        count++;
+    }
+    return count;
+}
+
+#ifdef SIM_TIMING
+static volatile uint16_t timerOverflows = 0;
+
+ISR(TIMER1_OVF_vect) {
+    timerOverflows++;
+}
+
+void startCycleCounter() {
+    TCCR1A = 0;
+    TCNT1 = 0;
+    TIFR1 = _BV(TOV1);
+    TIMSK1 = _BV(TOIE1);
+    TCCR1B = _BV(CS10);  // clk/1
+}
+
+uint32_t cycleCount() {
+    uint8_t oldSREG = SREG;
+    cli();
+    uint16_t low = TCNT1;
+    uint16_t high = timerOverflows;
+    if ((TIFR1 & _BV(TOV1)) && low < 0x8000) {
+        high++;  // Overflowed after interrupts were disabled, the ISR has not run yet
+    }
+    SREG = oldSREG;
+    return ((uint32_t)high << 16) | low;
+}
+
+void reportTiming(const __FlashStringHelper* name, uint32_t value) {
+    Serial.print(F("\r\n@T "));
+    Serial.print(name);
+    Serial.print(' ');
+    Serial.println(value);
+    Serial.flush();
+}
+
+void reportTiming(const __FlashStringHelper* name, const char* detail, uint32_t value) {
+    Serial.print(F("\r\n@T "));
+    Serial.print(name);
+    Serial.print(':');
+    Serial.print(detail);
+    Serial.print(' ');
+    Serial.println(value);
+    Serial.flush();
+}
+#endif
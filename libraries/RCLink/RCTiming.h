@@ -0,0 +1,56 @@
+#ifndef RC_TIMING_H
+#define RC_TIMING_H
+
+#include <Arduino.h>
+
+// ---- Stack high-water mark ----
+//
+// Free RAM between the heap and the stack is painted with a canary before any code runs
+// (.init3, right after the stack pointer is set up, see RCTiming.cpp). Counting the
+// canaries that are left gives the smallest gap the stack ever left, so the deepest stack
+// use since boot.
+
+const uint8_t STACK_CANARY = 0xC5;
+
+// Bytes between the heap and the deepest point the stack has reached
+uint16_t unusedStack();
+
+#ifdef SIM_TIMING
+// ---- Cycle counting for the emulator timing build ----
+//
+// Built only with SIM_TIMING defined (see tools/avr_timing.py, which runs the sketches
+// under simavr). Timer1 runs at the CPU clock and its overflows are counted, so
+// cycleCount() is exact to a few cycles of read overhead. Sketches that use Timer1 for
+// something else (Servo) must not start their own use of it in this build.
+
+void startCycleCounter();
+uint32_t cycleCount();
+
+// One result line for tools/avr_timing.py: "@T <name> <value>"
+void reportTiming(const __FlashStringHelper* name, uint32_t value);
+
+// Same with a detail after the name, "@T <name>:<detail> <value>", for one result per
+// command, input type or menu screen
+void reportTiming(const __FlashStringHelper* name, const char* detail, uint32_t value);
+
+// Worst cycle count of a few runs of run(), the first run also warms up lazy state. The
+// serial output of the previous run is drained first: at 9600 baud a byte takes ~16700
+// cycles, and a run that had to wait for room in the 64-byte TX buffer would measure the
+// UART instead of the code. What a run queues itself is counted (the buffer writes).
+const uint8_t TIMING_RUNS = 8;
+
+template<class F>
+uint32_t worstCycles(F run) {
+    uint32_t worst = 0;
+    for (uint8_t i = 0; i < TIMING_RUNS; i++) {
+        Serial.flush();
+        uint32_t start = cycleCount();
+        run();
+        uint32_t elapsed = cycleCount() - start;
+        if (elapsed > worst) worst = elapsed;
+    }
+    return worst;
+}
+#endif
+
+#endif // RC_TIMING_H
@@ -0,0 +1,151 @@
+"""Generate the Python protocol decoder (rc_protocol.py) from RCLink.h.
+
+Usage: python generate_protocol.py [output path]
+
+The field lists and constants are read from the shared header, so the Python side
+can never drift from the layout the boards are compiled with.
+"""
+import os
+import re
+import struct
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+HEADER = os.path.join(HERE, '..', 'RCLink.h')
+DEFAULT_OUTPUT = os.path.join(HERE, '..', '..', '..', 'rc_protocol.py')
+
+
+def read_constant(source, name):
+    match = re.search(r'const\s+\w+\s+%s\s*=\s*(0x[0-9A-Fa-f]+|\d+)\s*;' % name, source)
+    if not match:
+        sys.exit(f"{name} not found in RCLink.h")
+    return int(match.group(1), 0)
+
+
+def read_fields(source, macro):
+    body = re.search(r'#define\s+%s\(X\)((?:.*\\\n)*.*)' % macro, source)
+    if not body:
+        sys.exit(f"{macro} not found in RCLink.h")
+    fields = re.findall(r"X\(\s*\w+\s*,\s*(\w+)\s*,\s*'(.)'\s*\)", body.group(1))
+    if not fields:
+        sys.exit(f"{macro} has no fields")
+    return fields
+
+
+def main():
+    output = sys.argv[1] if len(sys.argv) > 1 else DEFAULT_OUTPUT
+    with open(HEADER) as f:
+        source = f.read()
+
+    schema_version = read_constant(source, 'RC_SCHEMA_VERSION')
+    channel_count = read_constant(source, 'RC_CHANNEL_COUNT')
+    config_size = read_constant(source, 'RC_CHANNEL_CONFIG_SIZE')
+    config_fields = read_fields(source, 'RC_CHANNEL_CONFIG_FIELDS')
+    frame_size = read_constant(source, 'RC_FRAME_SIZE')
+    frame_header_size = read_constant(source, 'RC_FRAME_HEADER_SIZE')
+    frame_timed = read_constant(source, 'RC_FRAME_TIMED')
+    frame_key = read_constant(source, 'RC_FRAME_KEY')
+    frame_delta = read_constant(source, 'RC_FRAME_DELTA')
+    frame_nibbles = read_constant(source, 'RC_FRAME_NIBBLES')
+    frame_config = read_constant(source, 'RC_FRAME_CONFIG')
+    receiver_config_version = read_constant(source, 'RC_RECEIVER_CONFIG_VERSION')
+    receiver_config_size = read_constant(source, 'RC_RECEIVER_CONFIG_SIZE')
+    frame_empty_slot = read_constant(source, 'RC_FRAME_EMPTY_SLOT')
+
+    config_format = '<' + ''.join(fmt for _, fmt in config_fields)
+    if struct.calcsize(config_format) != config_size:
+        sys.exit(f"{config_format} is {struct.calcsize(config_format)} bytes, RC_CHANNEL_CONFIG_SIZE is {config_size}")
+
+    names = ', '.join(repr(name) for name, _ in config_fields)
+    with open(output, 'w') as f:
+        f.write(f'''# Generated from libraries/RCLink/RCLink.h by extras/generate_protocol.py, do not edit
+import struct
+
+SCHEMA_VERSION = {schema_version}
+CHANNEL_COUNT = {channel_count}
+
+CHANNEL_CONFIG_FORMAT = '{config_format}'
+CHANNEL_CONFIG_FIELDS = ({names},)
+CHANNEL_CONFIG_SIZE = {config_size}
+
+CHANNEL_VALUES_FORMAT = '<B{channel_count}B'  # Model ID, then one byte per channel
+CHANNEL_VALUES_SIZE = {channel_count + 1}
+
+FRAME_SIZE = {frame_size}  # Largest radio payload: model ID, layout word, channel data
+FRAME_HEADER_SIZE = {frame_header_size}
+FRAME_TIMED = {frame_timed:#x}  # Layout flags, see RadioFrame in RCLink.h
+FRAME_KEY = {frame_key:#x}
+FRAME_DELTA = {frame_delta:#x}
+FRAME_NIBBLES = {frame_nibbles:#x}
+FRAME_CONFIG = {frame_config:#x}
+FRAME_EMPTY_SLOT = {frame_empty_slot:#x}
+
+RECEIVER_CONFIG_VERSION = {receiver_config_version}
+RECEIVER_CONFIG_SIZE = {receiver_config_size}  # tools/rx_config.py packs it
+
+
+def unpack_channel_config(data):
+    """Decode a "C" reply into a dict of field name to value."""
+    return dict(zip(CHANNEL_CONFIG_FIELDS, struct.unpack(CHANNEL_CONFIG_FORMAT, data)))
+
+
+def unpack_channel_values(data):
+    """Decode an "X" reply (or a trace record) into (model ID, list of channel values)."""
+    fields = struct.unpack(CHANNEL_VALUES_FORMAT, data)
+    return fields[0], list(fields[1:])
+
+
+class FrameDecoder:
+    """RCFrame.h FrameDecoder: applies radio payloads to a channel state like the receiver."""
+
+    def __init__(self):
+        self.key = None        # (sequence, values) of the last keyframe
+
+    def decode(self, data, values):
+        """Apply a payload to values (list of channel values). Returns (model ID, sample age
+        or None), or None if the payload is malformed or based on a missing keyframe."""
+        if len(data) < FRAME_HEADER_SIZE or len(data) > FRAME_SIZE:
+            return None
+        model, layout = struct.unpack_from('<BH', data)
+        if layout & FRAME_CONFIG:
+            return None
+        end = len(data) - (2 if layout & FRAME_TIMED else 0)
+        body = data[FRAME_HEADER_SIZE:end]
+        marked = [c for c in range(CHANNEL_COUNT) if layout & (1 << c)]
+        if layout & FRAME_KEY:
+            if len(body) != 1 + CHANNEL_COUNT:
+                return None
+            self.key = (body[0], list(body[1:]))
+            values[:] = self.key[1]
+        elif layout & FRAME_DELTA:
+            if not body or self.key is None or body[0] != self.key[0]:
+                return None
+            if layout & FRAME_NIBBLES:
+                nibbles = [n for b in body[1:] for n in (b & 0x0F, b >> 4)]
+                deltas = [n - 16 if n > 7 else n for n in nibbles]
+                if len(body) - 1 != (len(marked) + 1) // 2:
+                    return None
+            else:
+                deltas = [b - 256 if b > 127 else b for b in body[1:]]
+                if len(deltas) != len(marked):
+                    return None
+            values[:] = self.key[1]
+            for channel, delta in zip(marked, deltas):
+                values[channel] = (values[channel] + delta) & 0xFF
+        else:
+            if len(body) < len(marked):
+                return None
+            for channel, value in zip(marked, body):
+                values[channel] = value
+            slots = body[len(marked):]
+            for i in range(0, len(slots) - 1, 2):
+                if slots[i] < CHANNEL_COUNT:
+                    values[slots[i]] = slots[i + 1]
+        age = struct.unpack_from('<H', data, end)[0] if layout & FRAME_TIMED else None
+        return model, age
+''')
+    print(f"Wrote {os.path.normpath(output)} (schema {schema_version})")
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,85 @@
+# Generated from libraries/RCLink/RCLink.h by extras/generate_protocol.py, do not edit
+import struct
+
+SCHEMA_VERSION = 3
+CHANNEL_COUNT = 10
+
+CHANNEL_CONFIG_FORMAT = '<BcB?bhhBBB'
+CHANNEL_CONFIG_FIELDS = ('version', 'deviceType', 'deviceId', 'reverse', 'trim', 'analogReadMin', 'analogReadMax', 'minEndpoint', 'maxEndpoint', 'centerPoint',)
+CHANNEL_CONFIG_SIZE = 12
+
+CHANNEL_VALUES_FORMAT = '<B10B'  # Model ID, then one byte per channel
+CHANNEL_VALUES_SIZE = 11
+
+FRAME_SIZE = 16  # Largest radio payload: model ID, layout word, channel data
+FRAME_HEADER_SIZE = 3
+FRAME_TIMED = 0x8000  # Layout flags, see RadioFrame in RCLink.h
+FRAME_KEY = 0x4000
+FRAME_DELTA = 0x2000
+FRAME_NIBBLES = 0x1000
+FRAME_CONFIG = 0x800
+FRAME_EMPTY_SLOT = 0xff
+
+RECEIVER_CONFIG_VERSION = 1
+RECEIVER_CONFIG_SIZE = 28  # tools/rx_config.py packs it
+
+
+def unpack_channel_config(data):
+    """Decode a "C" reply into a dict of field name to value."""
+    return dict(zip(CHANNEL_CONFIG_FIELDS, struct.unpack(CHANNEL_CONFIG_FORMAT, data)))
+
+
+def unpack_channel_values(data):
+    """Decode an "X" reply (or a trace record) into (model ID, list of channel values)."""
+    fields = struct.unpack(CHANNEL_VALUES_FORMAT, data)
+    return fields[0], list(fields[1:])
+
+
+class FrameDecoder:
+    """RCFrame.h FrameDecoder: applies radio payloads to a channel state like the receiver."""
+
+    def __init__(self):
+        self.key = None        # (sequence, values) of the last keyframe
+
+    def decode(self, data, values):
+        """Apply a payload to values (list of channel values). Returns (model ID, sample age
+        or None), or None if the payload is malformed or based on a missing keyframe."""
+        if len(data) < FRAME_HEADER_SIZE or len(data) > FRAME_SIZE:
+            return None
+        model, layout = struct.unpack_from('<BH', data)
+        if layout & FRAME_CONFIG:
+            return None
+        end = len(data) - (2 if layout & FRAME_TIMED else 0)
+        body = data[FRAME_HEADER_SIZE:end]
+        marked = [c for c in range(CHANNEL_COUNT) if layout & (1 << c)]
+        if layout & FRAME_KEY:
+            if len(body) != 1 + CHANNEL_COUNT:
+                return None
+            self.key = (body[0], list(body[1:]))
+            values[:] = self.key[1]
+        elif layout & FRAME_DELTA:
+            if not body or self.key is None or body[0] != self.key[0]:
+                return None
+            if layout & FRAME_NIBBLES:
+                nibbles = [n for b in body[1:] for n in (b & 0x0F, b >> 4)]
+                deltas = [n - 16 if n > 7 else n for n in nibbles]
+                if len(body) - 1 != (len(marked) + 1) // 2:
+                    return None
+            else:
+                deltas = [b - 256 if b > 127 else b for b in body[1:]]
+                if len(deltas) != len(marked):
+                    return None
+            values[:] = self.key[1]
+            for channel, delta in zip(marked, deltas):
+                values[channel] = (values[channel] + delta) & 0xFF
+        else:
+            if len(body) < len(marked):
+                return None
+            for channel, value in zip(marked, body):
+                values[channel] = value
+            slots = body[len(marked):]
+            for i in range(0, len(slots) - 1, 2):
+                if slots[i] < CHANNEL_COUNT:
+                    values[slots[i]] = slots[i + 1]
+        age = struct.unpack_from('<H', data, end)[0] if layout & FRAME_TIMED else None
+        return model, age
@@ -2,7 +2,7 @@ import serial
 import serial.tools.list_ports
 import struct
 
-STRUCT_FORMAT = '<BcBBBhhBBB'  # Updated format
+from rc_protocol import CHANNEL_CONFIG_SIZE, unpack_channel_config  # Generated from RCLink.h
 
 def list_serial_ports():
     ports = serial.tools.list_ports.comports()
@@ -23,8 +23,8 @@ def main():
             break
 
         ser.write(f"{command}\n".encode())  # Send command to Arduino
-        data = ser.read(12)  # Read 12 bytes
-        if len(data) == 12:
+        data = ser.read(CHANNEL_CONFIG_SIZE)  # Read one config struct
+        if len(data) == CHANNEL_CONFIG_SIZE:
             print(f"Raw Data: {data.hex()}")
             parse_channel_config(data)
         else:
@@ -32,9 +32,9 @@ def main():
 
 def parse_channel_config(data):
     try:
-        values = struct.unpack(STRUCT_FORMAT, data)
-        print(f"Version: {values[0]}, Device Type: {values[1].decode()}, Device ID: {values[2]}, Reverse: {values[3]}, Trim: {values[4]}")
-        print(f"Analog Min: {values[5]}, Analog Max: {values[6]}, Min Endpoint: {values[7]}, Max Endpoint: {values[8]}, Center Point: {values[9]}")
+        values = unpack_channel_config(data)
+        print(f"Version: {values['version']}, Device Type: {values['deviceType'].decode()}, Device ID: {values['deviceId']}, Reverse: {values['reverse']}, Trim: {values['trim']}")
+        print(f"Analog Min: {values['analogReadMin']}, Analog Max: {values['analogReadMax']}, Min Endpoint: {values['minEndpoint']}, Max Endpoint: {values['maxEndpoint']}, Center Point: {values['centerPoint']}")
     except struct.error as e:
         print(f"Error parsing struct: {e}")
 
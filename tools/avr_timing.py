@@ -0,0 +1,186 @@
+"""Timing and memory regression check on the real AVR firmware.
+
+Builds each sketch twice with arduino-cli: the normal build for flash/RAM usage and a
+SIM_TIMING build that runs a timing script at boot. The timing build runs under simavr
+(cycle-accurate ATmega328P at 16 MHz). Its "@T <name> <value>" serial lines give worst
+cycle counts per hot path and the stack high-water mark. Every value is checked against
+avr_timing_budget.json and the run fails if any limit is exceeded. The script also reports
+a few functional checks, which must match the budget's "expect" values exactly. The
+Transmitter also times the pre-specialization Channel::read ("readLegacy:<device>"), and
+each of those is printed next to the current reader's "read:<device>".
+
+Measured values are also compared to the stored baseline (avr_timing_baseline.json): any
+cycle count, flash or RAM figure more than --threshold percent above its baseline, or
+unused stack that fell by more than that, fails the run. --update-baseline stores the
+current values instead: once to create the baseline file, then after a change that is
+meant to move them. No baseline has been committed yet, so until one is, a sketch without
+a baseline only gets a warning and the run is decided by the budget alone. Commit the
+file from the first run on real tools; the budget's cycle limits are estimates until
+then and should be tightened from the same run.
+
+Requires arduino-cli (with the arduino:avr core), avr-size and simavr on the PATH.
+
+Usage: python tools/avr_timing.py [--fqbn arduino:avr:uno] [--json results.json]
+                                  [--threshold 5] [--update-baseline] [sketch ...]
+"""
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+import threading
+
+ROOT = os.path.normpath(os.path.join(os.path.dirname(os.path.abspath(__file__)), '..'))
+BUDGET = os.path.join(ROOT, 'tools', 'avr_timing_budget.json')
+BASELINE = os.path.join(ROOT, 'tools', 'avr_timing_baseline.json')
+BUILD = os.path.join(ROOT, '_avr_timing')
+
+
+def compile_sketch(sketch, fqbn, timing):
+    output = os.path.join(BUILD, sketch + ('-timing' if timing else ''))
+    command = ['arduino-cli', 'compile', '--fqbn', fqbn,
+               '--libraries', os.path.join(ROOT, 'libraries'),
+               '--output-dir', output, os.path.join(ROOT, sketch)]
+    if timing:
+        command[2:2] = ['--build-property', 'compiler.cpp.extra_flags=-DSIM_TIMING']
+    subprocess.run(command, check=True, stdout=subprocess.DEVNULL)
+    return os.path.join(output, sketch + '.ino.elf')
+
+
+def memory_usage(elf):
+    sections = {}
+    for line in subprocess.run(['avr-size', '-A', elf], check=True, capture_output=True, text=True).stdout.splitlines():
+        parts = line.split()
+        if len(parts) >= 2 and parts[0].startswith('.') and parts[1].isdigit():
+            sections[parts[0]] = int(parts[1])
+    flash = sections.get('.text', 0) + sections.get('.data', 0)
+    ram = sections.get('.data', 0) + sections.get('.bss', 0)
+    return flash, ram
+
+
+def run_timing(elf, timeout):
+    """Run the timing build under simavr and collect its "@T" results."""
+    process = subprocess.Popen(['simavr', '-m', 'atmega328p', '-f', '16000000', elf],
+                               stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True, errors='replace')
+    timer = threading.Timer(timeout, process.kill)  # simavr keeps running after the script
+    timer.start()
+    results = {}
+    done = False
+    try:
+        for line in process.stdout:
+            match = re.search(r'@T (\S+) (\d+)', line)
+            if match:
+                if match.group(1) == 'done':
+                    done = True
+                    break
+                results[match.group(1)] = int(match.group(2))
+    finally:
+        timer.cancel()
+        process.kill()
+    if not done:
+        sys.exit(f"{elf}: no '@T done' within {timeout} s")
+    return results
+
+
+def check(name, value, limit, smaller_is_better=True):
+    ok = value <= limit if smaller_is_better else value >= limit
+    relation = '<=' if smaller_is_better else '>='
+    print(f"  {'ok  ' if ok else 'FAIL'} {name:28} {value:>8} (limit {relation} {limit})")
+    return ok
+
+
+def compare(sketch, measured, baseline, threshold):
+    """Flag every value that moved the wrong way by more than threshold percent. A sketch
+    without a baseline only warns, see the module docstring."""
+    if sketch not in baseline:
+        print(f"  WARN no baseline for {sketch}, regressions are not checked (store one with --update-baseline)")
+        return True
+    ok = True
+    for name, value in sorted(measured.items()):
+        if name not in baseline[sketch]:
+            print(f"  new  {name:28} {value:>8} (not in the baseline)")
+            continue
+        reference = baseline[sketch][name]
+        larger_is_better = name == 'unusedStack'
+        change = (value - reference) * 100.0 / max(reference, 1)
+        regressed = -change > threshold if larger_is_better else change > threshold
+        if regressed:
+            print(f"  FAIL {name:28} {value:>8} (baseline {reference}, {change:+.1f}%)")
+            ok = False
+    return ok
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('sketches', nargs='*', help='Sketches to check (default: all in the budget file)')
+    parser.add_argument('--fqbn', default='arduino:avr:uno')
+    parser.add_argument('--json', help='Write the measured values to this file')
+    parser.add_argument('--timeout', type=float, default=120)
+    parser.add_argument('--threshold', type=float, default=5,
+                        help='Allowed regression against the baseline in percent')
+    parser.add_argument('--update-baseline', action='store_true',
+                        help='Store the measured values as the new baseline')
+    args = parser.parse_args()
+
+    baseline = {}
+    if os.path.exists(BASELINE):
+        with open(BASELINE) as f:
+            baseline = json.load(f)
+
+    with open(BUDGET) as f:
+        budget = {k: v for k, v in json.load(f).items() if not k.startswith('_')}
+
+    measured = {}
+    passed = True
+    for sketch in args.sketches or budget:
+        limits = budget[sketch]
+        flash, ram = memory_usage(compile_sketch(sketch, args.fqbn, timing=False))
+        results = run_timing(compile_sketch(sketch, args.fqbn, timing=True), args.timeout)
+        measured[sketch] = {'flash': flash, 'ram': ram, **results}
+
+        print(sketch)
+        passed &= check('flash', flash, limits['max_flash'])
+        passed &= check('ram', ram, limits['max_ram'])
+        if 'unusedStack' not in results:
+            print("  FAIL unusedStack not reported")
+            passed = False
+        else:
+            passed &= check('unusedStack', results['unusedStack'], limits['min_unused_stack'], smaller_is_better=False)
+        for name, limit in limits['max_cycles'].items():
+            if name not in results:
+                print(f"  FAIL {name} not reported")
+                passed = False
+            else:
+                passed &= check(name, results[name], limit)
+        for name, expected in limits.get('expect', {}).items():
+            if results.get(name) != expected:
+                print(f"  FAIL {name:28} {results.get(name, 'not reported'):>8} (expected {expected})")
+                passed = False
+            else:
+                print(f"  ok   {name:28} {expected:>8}")
+        for name in sorted(set(results) - set(limits['max_cycles']) - set(limits.get('expect', {})) - {'unusedStack'}):
+            print(f"       {name:28} {results[name]:>8}")
+        for name in sorted(n for n in results if n.startswith('readLegacy:')):
+            current = results.get('read:' + name.split(':', 1)[1])
+            if current is not None:
+                print(f"       {name.replace('readLegacy', 'read'):28} {current:>8} vs {results[name]} before "
+                      f"({(current - results[name]) * 100.0 / max(results[name], 1):+.1f}%)")
+        if not args.update_baseline:
+            passed &= compare(sketch, measured[sketch], baseline, args.threshold)
+
+    if args.update_baseline:
+        baseline.update(measured)
+        with open(BASELINE, 'w') as f:
+            json.dump(baseline, f, indent=2, sort_keys=True)
+            f.write('\n')
+        print(f"Baseline updated: {os.path.relpath(BASELINE, ROOT)}")
+
+    if args.json:
+        with open(args.json, 'w') as f:
+            json.dump(measured, f, indent=2)
+    sys.exit(0 if passed else 1)
+
+
+if __name__ == '__main__':
+    main()
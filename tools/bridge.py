@@ -0,0 +1,129 @@
+"""Drive channels from the PC through the transmitter's bridge mode (Transmitter/SerialBridge.h).
+
+Channel values (0-255) are read from stdin, one line per frame with a value for each
+--override channel and then each --mix channel (mix values are centered on 128), and
+streamed at --hz. Without stdin input (--sweep) the channels sweep their range as a test.
+If the stream stalls for 100 ms the transmitter hands control back to its sticks, after
+1 s it leaves bridge mode (so a vanished host cannot lock out the config panel).
+
+Requires pyserial.
+
+Usage: python tools/bridge.py --port /dev/ttyUSB0 --override 0,1,2,3 < values.txt
+       python tools/bridge.py --port /dev/ttyUSB0 --override 2 --mix 0 --sweep --seconds 5
+"""
+import argparse
+import math
+import struct
+import sys
+import time
+
+SYNC = 0xA5
+DEFAULT_BAUD = 9600           # Transmitter boot rate
+
+
+def crc8(data):
+    # _crc8_ccitt_update: polynomial 0x07, initial value 0
+    crc = 0
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def channel_record(overrides, mixes, values):
+    """'W' record: values are given for overrides then mixes, sent in channel order."""
+    by_channel = dict(zip(list(overrides) + list(mixes), values))
+    override_mask = sum(1 << c for c in overrides)
+    mix_mask = sum(1 << c for c in mixes)
+    body = bytes([ord('W')]) + struct.pack('<HH', override_mask, mix_mask) + \
+        bytes(by_channel[c] for c in sorted(by_channel))
+    return bytes([SYNC]) + body + bytes([crc8(body)])
+
+
+def end_record():
+    body = b'E'
+    return bytes([SYNC]) + body + bytes([crc8(body)])
+
+
+def open_transmitter(port, rate):
+    import serial
+
+    link = serial.Serial(port, DEFAULT_BAUD, timeout=1)
+    time.sleep(2)  # Opening the port resets the board
+    link.reset_input_buffer()
+    if rate != DEFAULT_BAUD:
+        # Same negotiation as the config panel: "B<rate>", then the "K" echo test
+        link.write(b'B%d\n' % rate)
+        if link.readline().strip() != b'Y':
+            sys.exit(f'transmitter refused {rate} baud')
+        link.baudrate = rate
+        link.write(b'K42\n')
+        if link.readline().strip() != b'42':
+            sys.exit(f'no echo at {rate} baud')
+    return link
+
+
+def stdin_frames(count):
+    for line in sys.stdin:
+        values = [int(v) for v in line.replace(',', ' ').split()]
+        if len(values) != count or any(not 0 <= v <= 255 for v in values):
+            sys.exit(f'expected {count} values 0-255 per line, got: {line.strip()}')
+        yield values
+
+
+def sweep_frames(count, hz, seconds):
+    for i in range(int(hz * seconds)):
+        value = int(127.5 + 127.5 * math.sin(2 * math.pi * i / hz))
+        yield [value] * count
+
+
+def channel_list(text):
+    return [int(c) for c in text.split(',')] if text else []
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--port', required=True)
+    parser.add_argument('--rate', type=int, default=250000, help='transmitter link rate to negotiate')
+    parser.add_argument('--override', type=channel_list, default=[], help='channels replaced by the PC')
+    parser.add_argument('--mix', type=channel_list, default=[], help='channels the PC adds an offset to')
+    parser.add_argument('--hz', type=float, default=200, help='records per second (one per 5 ms frame)')
+    parser.add_argument('--sweep', action='store_true', help='sweep the channels instead of reading stdin')
+    parser.add_argument('--seconds', type=float, default=10, help='sweep duration')
+    args = parser.parse_args()
+
+    count = len(args.override) + len(args.mix)
+    if count == 0:
+        parser.error('give --override and/or --mix channels')
+
+    link = open_transmitter(args.port, args.rate)
+    link.write(b'W\n')
+    if link.readline().strip() != b'Y':
+        sys.exit('transmitter refused bridge mode')
+
+    frames = sweep_frames(count, args.hz, args.seconds) if args.sweep else stdin_frames(count)
+    period = 1 / args.hz
+    next_time = time.monotonic()
+    sent = 0
+    try:
+        for values in frames:
+            link.write(channel_record(args.override, args.mix, values))
+            sent += 1
+            next_time += period
+            time.sleep(max(0, next_time - time.monotonic()))
+    except KeyboardInterrupt:
+        pass
+
+    link.write(end_record())
+    link.readline()
+    link.write(b'WS\n')
+    counters = link.read(6)
+    link.close()
+    if len(counters) == 6:
+        frames_ok, errors, timeouts = struct.unpack('<HHH', counters)
+        print(f'{sent} records sent, {frames_ok} accepted, {errors} dropped, {timeouts} stalls')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,408 @@
+"""End-to-end radio link simulation of the transmitter and receiver sketches.
+
+Models, with the constants of the sketches:
+- the transmitter: one frame every FRAME_PERIOD_US. Each stick goes through Channel::read
+  at its default config, map(raw, 0, 1023, 0, 255), and is packed by rate class like
+  RCFrame.h's FrameEncoder: RATE_EVERY_FRAME channels in the fixed part, the others in
+  slots for the due channels, most overdue first, or in delta mode (--keyframe) as keyframes and
+  differences to them.
+- the nRF24 link: dynamic payload lengths, no acks. Frames take their airtime at the
+  configured data rate and can be delayed, lost (random, bursty Gilbert-Elliott or in
+  periodic interference windows) or corrupted. The CRC-16 drops corrupted frames.
+- the receiver: a loop() polling a 3-deep RX FIFO, the model ID check, rebuilding the
+  channel state from the frames (deltas without their keyframe are dropped), the 1 s failsafe and Servo pulses refreshed every 20 ms.
+
+Stick changes come from a script and every servo pulse is recorded, so stick-to-servo
+latency and failsafe entry and exit can be measured. Runs are seeded and repeatable.
+
+Frames also carry the RC_LATENCY sample age (RC_FRAME_TIMED) and the receiver model
+reports the same estimate as Receiver.ino's latency mode, sample age + airtime + receive to
+the pulse edge of channel 1, next to the true latency from the sample to that edge.
+
+Script (JSON): {"duration_ms": 3000, "steps": [{"t_ms": 100, "channel": 0, "raw": 1023}, ...],
+"outages": [{"t_ms": 1000, "duration_ms": 1500}]}. Without --script a throttle step
+every 250 ms and a 1.5 s outage are used.
+
+Usage: python tools/link_sim.py [--script s.json] [--loss 0.02] [--burst 0.01,0.3]
+                                [--interference 100,3] [--corrupt 0.001] [--delay 0.5,0.2]
+                                [--rate 250k] [--sample-age-us 700] [--rates 0,0,0,0,2,2,2,2,2,2]
+                                [--keyframe 10]                                [--csv servo.csv] [--seed 1]
+"""
+import argparse
+import csv
+import json
+import os
+import random
+import struct
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..'))
+from rc_protocol import (CHANNEL_COUNT, FRAME_SIZE, FRAME_TIMED, FRAME_KEY, FRAME_DELTA, FRAME_NIBBLES,
+                         FrameDecoder)  # Generated from RCLink.h
+
+FRAME_PERIOD_US = 5000      # Transmitter/CommunicationHandler.h
+FAILSAFE_MS = 1000          # Receiver.ino: signal lost after 1 s
+SERVO_OUTPUTS = 10          # Receiver.ino: servoPins
+SERVO_REFRESH_US = 20000    # Servo library frame
+RX_FIFO_DEPTH = 3           # nRF24L01 RX FIFO
+TX_SETTLING_US = 130        # nRF24L01 PLL settling before each packet
+RATE_EVERY_FRAME, RATE_EVERY_4TH, RATE_ON_CHANGE = 0, 1, 2  # RCFrame.h RateClass
+RATE_SLOW_FRAMES = 4
+RATE_REFRESH_FRAMES = 20
+DEFAULT_RATES = [RATE_EVERY_FRAME] * 4 + [RATE_ON_CHANGE] * (CHANNEL_COUNT - 4)  # InputHandler defaults
+DATA_RATES = {'250k': 250000, '1m': 1000000, '2m': 2000000}
+
+
+def airtime_us(rate, length):
+    # Preamble, 5-byte address, 9-bit packet control field, payload, 2-byte CRC
+    bits = 8 * (1 + 5 + length + 2) + 9
+    return TX_SETTLING_US + bits * 1000000 // rate
+
+
+def failsafe_values():
+    # Receiver.ino reset_the_Data(): throttle and aux low, sticks centered
+    return [127 if 1 <= i <= 4 else 0 for i in range(CHANNEL_COUNT)]
+
+
+def arduino_map(x, in_min, in_max, out_min, out_max):
+    return (x - in_min) * (out_max - out_min) // (in_max - in_min) + out_min
+
+
+def channel_read(raw):
+    # Channel::read with the defaults of InputHandler::initializeChannel
+    return max(0, min(255, arduino_map(raw, 0, 1023, 0, 255)))
+
+
+class FrameEncoder:
+    """RCFrame.h FrameEncoder, always with the sample age (RC_LATENCY layout)."""
+
+    def __init__(self, rates, keyframe_interval):
+        self.rates = rates
+        self.keyframe_interval = keyframe_interval
+        self.since = [255] * CHANNEL_COUNT
+        self.sent = [0] * CHANNEL_COUNT
+        self.key = [0] * CHANNEL_COUNT
+        self.key_sequence = 0
+        self.since_key = 255
+
+    def due(self, channel, value):
+        if self.rates[channel] == RATE_ON_CHANGE:
+            return value != self.sent[channel] or self.since[channel] >= RATE_REFRESH_FRAMES
+        return self.since[channel] >= RATE_SLOW_FRAMES
+
+    def encode(self, model, values, sample_age):
+        if self.keyframe_interval:
+            layout, data = self.encode_delta(values)
+        else:
+            layout, data = self.encode_slots(values)
+        return struct.pack('<BH', model, layout) + bytes(data) + struct.pack('<H', sample_age)
+
+    def encode_delta(self, values):
+        self.since_key = min(255, self.since_key + 1)
+        deltas = [v - k for v, k in zip(values, self.key)]
+        if self.since_key >= self.keyframe_interval or any(not -128 <= d <= 127 for d in deltas):
+            self.key_sequence = (self.key_sequence + 1) & 0xFF
+            self.key = list(values)
+            self.since_key = 0
+            return FRAME_TIMED | FRAME_KEY | ((1 << CHANNEL_COUNT) - 1), [self.key_sequence] + self.key
+
+        layout = FRAME_TIMED | FRAME_DELTA
+        changed = [(c, d) for c, d in enumerate(deltas) if d]
+        for channel, _ in changed:
+            layout |= 1 << channel
+        if all(-8 <= d <= 7 for _, d in changed):
+            layout |= FRAME_NIBBLES
+            nibbles = [d & 0x0F for _, d in changed] + [0]
+            data = [nibbles[i] | nibbles[i + 1] << 4 for i in range(0, len(changed), 2)]
+        else:
+            data = [d & 0xFF for _, d in changed]
+        return layout, [self.key_sequence] + data
+
+    def encode_slots(self, values):
+        layout = FRAME_TIMED
+        data = bytearray()
+        for channel in range(CHANNEL_COUNT):
+            self.since[channel] = min(255, self.since[channel] + 1)
+            if self.rates[channel] == RATE_EVERY_FRAME:
+                layout |= 1 << channel
+                data.append(values[channel])
+                self.since[channel] = 0
+
+        # Only due channels get a slot, the frame ends after the last one
+        room = FRAME_SIZE - 3 - 2
+        while len(data) + 2 <= room:
+            due = [(self.since[c], -c) for c in range(CHANNEL_COUNT)
+                   if self.since[c] != 0 and self.due(c, values[c])]
+            if not due:
+                break
+            channel = -max(due)[1]
+            data += bytes([channel, values[channel]])
+            self.sent[channel] = values[channel]
+            self.since[channel] = 0
+        return layout, data
+
+
+class Link:
+    """Loss, delay and corruption between the two radios."""
+
+    def __init__(self, args, rng):
+        self.rng = rng
+        self.loss = args.loss
+        self.burst = args.burst            # (P good->bad, P bad->good), every frame is lost while bad
+        self.bad = False
+        self.interference = args.interference  # (period ms, duration ms)
+        self.corrupt = args.corrupt
+        self.delay = args.delay            # (mean ms, jitter ms)
+        self.rate = DATA_RATES[args.rate]
+        self.outages = []
+
+    def jammed(self, start, end):
+        if any(o[0] <= start < o[1] or o[0] < end <= o[1] for o in self.outages):
+            return True
+        if self.interference:
+            period, duration = (int(v * 1000) for v in self.interference)
+            return start % period < duration or end % period < duration
+        return False
+
+    def send(self, now, payload):
+        """Arrival time at the receiver's FIFO and the payload, or None if lost."""
+        end = now + airtime_us(self.rate, len(payload))
+        if self.burst:
+            p_enter, p_leave = self.burst
+            self.bad = (self.rng.random() >= p_leave) if self.bad else (self.rng.random() < p_enter)
+            if self.bad:
+                return None
+        if self.rng.random() < self.loss or self.jammed(now, end):
+            return None
+        if self.rng.random() < self.corrupt:
+            return None  # Bit errors, the receiver's CRC-16 drops the frame
+        if self.delay:
+            mean, jitter = self.delay
+            end += max(0, int((mean + self.rng.uniform(-jitter, jitter)) * 1000))
+        return end, payload
+
+
+class Receiver:
+    """Receiver.ino loop(): drain the FIFO, failsafe after 1 s, servo pulses."""
+
+    def __init__(self, model_id, loop_us):
+        self.model_id = model_id
+        self.loop_us = loop_us
+        self.fifo = []
+        self.values = failsafe_values()
+        self.decoder = FrameDecoder()
+        self.last_recv_ms = 0
+        self.overflows = 0
+        self.dropped = 0            # Deltas without their keyframe
+        self.received = 0
+        self.in_failsafe = True
+        self.failsafe_events = []   # (time ms, True on entry / False on exit)
+        self.frame = None           # (sample age, receive time, true sample time) of the last frame
+        self.armed = None           # The frame written to the servos, waiting for its pulse
+        self.estimated = []         # Receiver.ino's latency estimate per measured pulse, us
+        self.actual = []            # True sample-to-edge latency of the same pulses, us
+
+    def arrive(self, payload, sample_time):
+        if len(self.fifo) < RX_FIFO_DEPTH:
+            self.fifo.append((payload, sample_time))
+        else:
+            self.overflows += 1  # FIFO full, the nRF24 drops the new packet
+
+    def loop(self, now):
+        while self.fifo:
+            payload, sample_time = self.fifo.pop(0)
+            if payload[0] != self.model_id:
+                continue
+            decoded = self.decoder.decode(payload, self.values)
+            if decoded is None:
+                self.dropped += 1
+                continue
+            # The estimate assumes 250 kbps like Receiver.ino
+            self.frame = (decoded[1] + airtime_us(DATA_RATES['250k'], len(payload)), now, sample_time)
+            self.last_recv_ms = now // 1000
+            self.received += 1
+            if self.in_failsafe:
+                self.in_failsafe = False
+                self.failsafe_events.append((now / 1000, False))
+
+        if now // 1000 - self.last_recv_ms > FAILSAFE_MS:
+            self.values = failsafe_values()
+            self.decoder = FrameDecoder()
+            if not self.in_failsafe:
+                self.in_failsafe = True
+                self.failsafe_events.append((now / 1000, True))
+
+        if self.frame:
+            self.armed, self.frame = self.frame, None
+
+    def edge(self, now):
+        """Rising edge of channel 1's pulse."""
+        if self.armed:
+            age, received, sample_time = self.armed  # Sample age + airtime
+            self.estimated.append(age + now - received)
+            self.actual.append(now - sample_time)
+            self.armed = None
+
+    def pulse(self, channel):
+        return arduino_map(self.values[channel], 0, 255, 1000, 2000)
+
+
+def default_script():
+    steps = [{'t_ms': t, 'channel': 0, 'raw': 1023 if (t // 250) % 2 else 0} for t in range(250, 3000, 250)]
+    return {'duration_ms': 4000, 'steps': steps, 'outages': [{'t_ms': 1000, 'duration_ms': 1500}]}
+
+
+def simulate(script, args):
+    rng = random.Random(args.seed)
+    link = Link(args, rng)
+    link.outages = [(o['t_ms'] * 1000, (o['t_ms'] + o['duration_ms']) * 1000) for o in script.get('outages', [])]
+    receiver = Receiver(args.model, args.loop_us)
+    encoder = FrameEncoder(args.rates, args.keyframe)
+
+    sticks = [512] * CHANNEL_COUNT
+    steps = sorted(script['steps'], key=lambda s: s['t_ms'])
+    in_flight = []     # (arrival us, payload, sample time us)
+    pulses = []        # (time ms, channel, pulse us)
+    sent = lost = airtime = 0
+
+    duration = script['duration_ms'] * 1000
+    next_frame = 0
+    next_loop = 0
+    next_servo = 0
+    now = 0
+    while now < duration:
+        now = min(next_frame, next_loop, next_servo)
+        while steps and steps[0]['t_ms'] * 1000 <= now:
+            step = steps.pop(0)
+            sticks[step['channel']] = step['raw']
+
+        if now == next_frame:
+            # Inputs are sampled sample_age_us before the radio write
+            values = [channel_read(r) for r in sticks]
+            payload = encoder.encode(args.model, values, args.sample_age_us)
+            sent += 1
+            airtime += airtime_us(DATA_RATES[args.rate], len(payload))
+            delivery = link.send(now, payload)
+            if delivery is None:
+                lost += 1
+            else:
+                in_flight.append(delivery + (now - args.sample_age_us,))
+            next_frame += FRAME_PERIOD_US
+
+        for delivery in [d for d in in_flight if d[0] <= now]:
+            in_flight.remove(delivery)
+            receiver.arrive(delivery[1], delivery[2])
+
+        if now == next_loop:
+            receiver.loop(now)
+            next_loop += receiver.loop_us
+
+        if now == next_servo:
+            # The Servo library sends the pulses one after another in each 20 ms frame
+            start = now
+            receiver.edge(now)
+            for channel in range(SERVO_OUTPUTS):
+                width = receiver.pulse(channel)
+                pulses.append((start / 1000, channel, width))
+                start += width
+            next_servo += SERVO_REFRESH_US
+
+    return {'sent': sent, 'lost': lost, 'airtime': airtime // max(1, sent), 'receiver': receiver, 'pulses': pulses}
+
+
+def step_latencies(script, pulses):
+    """Time from each stick step to the first pulse within 1% of the commanded value.
+
+    Steps the servo already showed (no change, or the failsafe value) are skipped."""
+    latencies = []
+    for step in sorted(script['steps'], key=lambda s: s['t_ms']):
+        target = arduino_map(channel_read(step['raw']), 0, 255, 1000, 2000)
+        shown = [(time, width) for time, channel, width in pulses if channel == step['channel']]
+        before = [width for time, width in shown if time < step['t_ms']]
+        if before and abs(before[-1] - target) <= 10:
+            continue
+        reached = [time for time, width in shown if time >= step['t_ms'] and abs(width - target) <= 10]
+        latencies.append((step['t_ms'], reached[0] - step['t_ms'] if reached else None))
+    return latencies
+
+
+def percentiles(samples):
+    """Receiver.ino's report line, from exact rather than bucketed percentiles."""
+    ordered = sorted(samples)
+    pick = lambda p: ordered[max(0, (len(ordered) * p + 99) // 100 - 1)]
+    return f"n={len(ordered)} p50={pick(50)} p90={pick(90)} p99={pick(99)} max={ordered[-1]}"
+
+
+def rate_classes(text):
+    rates = [int(v) for v in text.split(',')]
+    if len(rates) != CHANNEL_COUNT or any(r not in (RATE_EVERY_FRAME, RATE_EVERY_4TH, RATE_ON_CHANGE) for r in rates):
+        raise argparse.ArgumentTypeError(f'expected {CHANNEL_COUNT} rate classes 0-2')
+    return rates
+
+
+def pair(text, kind=float):
+    values = tuple(kind(v) for v in text.split(','))
+    if len(values) != 2:
+        raise argparse.ArgumentTypeError('expected two comma-separated values')
+    return values
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--script', help='JSON stick script (see above)')
+    parser.add_argument('--loss', type=float, default=0.0, help='Random loss probability per frame')
+    parser.add_argument('--burst', type=pair, help='Gilbert-Elliott P(enter),P(leave) of the lossy state')
+    parser.add_argument('--interference', type=pair, help='Jamming window: period ms,duration ms')
+    parser.add_argument('--corrupt', type=float, default=0.0, help='Bit error probability per frame')
+    parser.add_argument('--delay', type=pair, help='Extra delivery delay: mean ms,jitter ms')
+    parser.add_argument('--rate', choices=DATA_RATES, default='250k', help='nRF24 data rate (sketches use 250k)')
+    parser.add_argument('--loop-us', type=int, default=200, help='Receiver loop() period')
+    parser.add_argument('--sample-age-us', type=int, default=700,
+                        help='Input sample to radio write on the transmitter (reads, curves, mixer)')
+    parser.add_argument('--rates', type=rate_classes, default=DEFAULT_RATES,
+                        help='Rate class per channel: 0 every frame, 1 every 4th, 2 on change ("J" command)')
+    parser.add_argument('--keyframe', type=int, default=0,
+                        help='Delta mode with a keyframe every this many frames ("JD=" command), 0 is off')
+    parser.add_argument('--model', type=int, default=0, help='Model ID of transmitter and receiver')
+    parser.add_argument('--csv', help='Write every servo pulse (time ms, channel, pulse us)')
+    parser.add_argument('--seed', type=int, default=1)
+    args = parser.parse_args()
+
+    if args.script:
+        with open(args.script) as f:
+            script = json.load(f)
+    else:
+        script = default_script()
+
+    result = simulate(script, args)
+    receiver = result['receiver']
+
+    print(f"mean airtime {result['airtime']} us, frames sent {result['sent']}, lost on air {result['lost']}, "
+          f"received {receiver.received}, FIFO overflows {receiver.overflows}, dropped deltas {receiver.dropped}")
+
+    latencies = step_latencies(script, result['pulses'])
+    measured = [l for _, l in latencies if l is not None]
+    if measured:
+        measured.sort()
+        print(f"stick-to-servo latency: min {measured[0]:.1f} ms, median {measured[len(measured) // 2]:.1f} ms, "
+              f"max {measured[-1]:.1f} ms over {len(measured)} steps")
+    for t, latency in latencies:
+        if latency is None:
+            print(f"  step at {t} ms never reached the servo")
+
+    if receiver.estimated:
+        print(f"latency {percentiles(receiver.estimated)}")
+        print(f"true    {percentiles(receiver.actual)}")
+
+    for time, entered in receiver.failsafe_events:
+        print(f"failsafe {'entered' if entered else 'left'} at {time:.1f} ms")
+
+    if args.csv:
+        with open(args.csv, 'w', newline='') as f:
+            writer = csv.writer(f)
+            writer.writerow(['time_ms', 'channel', 'pulse_us'])
+            writer.writerows(result['pulses'])
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,128 @@
+"""Decode the hot-path profiling report of an RC_PROFILE build (RCProfiler.h).
+
+Sends the request over the serial port ("P\\n" for the transmitter, a bare "P" for the
+receiver) and prints per stage the sample count, worst time, budget overruns and the
+latency histogram. A report saved to a file can be decoded with --file.
+
+Requires pyserial unless --file is used.
+
+Usage: python tools/profile_decode.py --port /dev/ttyUSB0 [--baud 9600] [--bare] [--reset]
+       python tools/profile_decode.py --file report.bin
+"""
+import argparse
+import io
+import struct
+import sys
+
+FORMAT_VERSION = 1
+NO_BUDGET = 0xFFFF
+SATURATED = 0xFFFF
+
+
+def bucket_labels(count):
+    # Power-of-two buckets: < 16 us, < 32 us, ..., >= the last bound
+    labels = ['<%d' % (16 << i) for i in range(count - 1)]
+    labels.append('>=%d' % (16 << (count - 2)))
+    return labels
+
+
+def read_exact(stream, size):
+    data = stream.read(size)
+    if len(data) != size:
+        raise ValueError('report truncated')
+    return data
+
+
+def read_name(stream):
+    name = bytearray()
+    while True:
+        byte = read_exact(stream, 1)
+        if byte == b'\0':
+            return name.decode('ascii')
+        name += byte
+
+
+def decode(stream):
+    version, stage_count, bucket_count = struct.unpack('<BBB', read_exact(stream, 3))
+    if version != FORMAT_VERSION:
+        raise ValueError('unsupported report format %d' % version)
+
+    stats_format = '<HH%dHHH' % bucket_count  # budget, count, buckets, max, overruns
+    stages = []
+    for _ in range(stage_count):
+        name = read_name(stream)
+        fields = struct.unpack(stats_format, read_exact(stream, struct.calcsize(stats_format)))
+        stages.append({
+            'name': name,
+            'budget': None if fields[0] == NO_BUDGET else fields[0],
+            'count': fields[1],
+            'buckets': list(fields[2:2 + bucket_count]),
+            'max': fields[2 + bucket_count],
+            'overruns': fields[3 + bucket_count],
+        })
+    return stages, bucket_count
+
+
+def counter(value):
+    return '%d+' % value if value == SATURATED else str(value)
+
+
+def print_report(stages, bucket_count):
+    labels = bucket_labels(bucket_count)
+    print('%-10s %7s %7s %7s %9s' % ('stage', 'count', 'max us', 'budget', 'overruns'))
+    for stage in stages:
+        budget = '-' if stage['budget'] is None else str(stage['budget'])
+        print('%-10s %7s %7d %7s %9s' % (stage['name'], counter(stage['count']), stage['max'],
+                                         budget, counter(stage['overruns'])))
+
+    for stage in stages:
+        total = sum(stage['buckets'])
+        if total == 0:
+            continue
+        print('\n%s' % stage['name'])
+        for label, value in zip(labels, stage['buckets']):
+            if value == 0:
+                continue
+            bar = '#' * max(1, value * 40 // total)
+            print('  %7s us %7s %s' % (label, counter(value), bar))
+
+
+def request(port, baud, bare, reset):
+    import serial
+
+    with serial.Serial(port, baud, timeout=2) as link:
+        link.reset_input_buffer()
+        link.write(b'P' if bare else b'P\n')
+        report = io.BytesIO(link.read(4096))
+        if reset and not bare:
+            link.write(b'PZ\n')
+            link.readline()
+        return report
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--port', help='serial port of the board')
+    parser.add_argument('--baud', type=int, default=9600)
+    parser.add_argument('--bare', action='store_true', help='receiver (no newline)')
+    parser.add_argument('--reset', action='store_true', help='clear the transmitter counters afterwards')
+    parser.add_argument('--file', help='decode a saved report instead')
+    args = parser.parse_args()
+
+    if args.file:
+        with open(args.file, 'rb') as report_file:
+            report = io.BytesIO(report_file.read())
+    elif args.port:
+        report = request(args.port, args.baud, args.bare, args.reset)
+    else:
+        parser.error('--port or --file is required')
+
+    try:
+        stages, bucket_count = decode(report)
+    except (ValueError, struct.error) as error:
+        sys.exit('Cannot decode the report: %s (is the board built with RC_PROFILE?)' % error)
+    print_report(stages, bucket_count)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,98 @@
+"""Configure the receiver over the air through the transmitter (ReceiverConfig in RCLink.h).
+
+The config is staged on the transmitter ("JR<offset>=<hex>"), sent with "JRS" and then
+polled with "JR" until the receiver has applied or rejected it. The receiver must be on
+and following the transmitter's active model; it keeps the config in EEPROM.
+
+Requires pyserial.
+
+Usage: python tools/rx_config.py --port /dev/ttyUSB0 --pins 2,3,4,5,6,7,8,17,18,19
+       python tools/rx_config.py --port /dev/ttyUSB0 --model 1 --failsafe 0,127,127,127,127 --failsafe-ms 500
+"""
+import argparse
+import os
+import struct
+import sys
+import time
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..'))
+from rc_protocol import CHANNEL_COUNT, RECEIVER_CONFIG_SIZE, RECEIVER_CONFIG_VERSION  # Generated from RCLink.h
+from bridge import open_transmitter
+
+CONFIG_FORMAT = f'<BB{CHANNEL_COUNT}B{CHANNEL_COUNT}BHHH'
+NO_OUTPUT = 0xFF
+CHUNK = 11                 # Bytes per "JR" command (RC_CONFIG_CHUNK), within the 40 character command buffer
+STATES = ['idle', 'sending', 'applied', 'rejected', 'failed']
+RESULTS = ['none', 'stored', 'applied', 'rejected']
+
+assert struct.calcsize(CONFIG_FORMAT) == RECEIVER_CONFIG_SIZE, 'ReceiverConfig changed'
+
+
+def padded(values, count, fill):
+    if len(values) > count:
+        sys.exit(f'at most {count} values')
+    return list(values) + [fill] * (count - len(values))
+
+
+def pack_config(args):
+    pins = padded(args.pins, CHANNEL_COUNT, NO_OUTPUT)
+    failsafe = padded(args.failsafe, CHANNEL_COUNT, 0)
+    return struct.pack(CONFIG_FORMAT, RECEIVER_CONFIG_VERSION, args.model,
+                       *pins, *failsafe, args.pulse_min, args.pulse_max, args.failsafe_ms)
+
+
+def command(link, text):
+    link.write(text.encode() + b'\n')
+    if link.readline().strip() != b'Y':
+        sys.exit(f'transmitter refused {text}')
+
+
+def status(link):
+    # State byte, uint16 messages sent, then the receiver's ReceiverStatus
+    link.write(b'JR\n')
+    reply = link.read(7)
+    if len(reply) != 7:
+        sys.exit('no reply to JR')
+    return struct.unpack('<BHBBH', reply)
+
+
+def value_list(text):
+    return [NO_OUTPUT if v == '-' else int(v) for v in text.split(',')] if text else []
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--port', required=True)
+    parser.add_argument('--rate', type=int, default=250000, help='transmitter link rate to negotiate')
+    parser.add_argument('--model', type=int, default=0, help='transmitter model slot to follow')
+    parser.add_argument('--pins', type=value_list, default=[2, 3, 4, 5, 6, 7, 8, 17, 18, 19],
+                        help="output pin per channel, '-' for none (not 0-1 or 9-13)")
+    parser.add_argument('--failsafe', type=value_list, default=[0, 127, 127, 127, 127],
+                        help='channel values (0-255) after a loss of signal, the rest 0')
+    parser.add_argument('--pulse-min', type=int, default=1000, help='pulse width of value 0 (544 or more)')
+    parser.add_argument('--pulse-max', type=int, default=2000, help='pulse width of value 255 (2400 or less)')
+    parser.add_argument('--failsafe-ms', type=int, default=1000, help='signal loss before failsafe (100 or more)')
+    parser.add_argument('--timeout', type=float, default=5, help='seconds to wait for the receiver')
+    args = parser.parse_args()
+
+    config = pack_config(args)
+    link = open_transmitter(args.port, args.rate)
+    for offset in range(0, len(config), CHUNK):
+        command(link, f'JR{offset}={config[offset:offset + CHUNK].hex()}')
+    command(link, 'JRS')
+
+    deadline = time.monotonic() + args.timeout
+    while True:
+        state, attempts, sequence, result, crc = status(link)
+        if STATES[state] != 'sending' or time.monotonic() > deadline:
+            break
+        time.sleep(0.05)
+    link.close()
+
+    print(f'{STATES[state]} after {attempts} messages, receiver: {RESULTS[result]} '
+          f'(message {sequence}, config CRC {crc:04x})')
+    sys.exit(0 if STATES[state] == 'applied' else 1)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,243 @@
+"""Record, decode and replay input traces (RC_TRACE builds, see Transmitter/InputTrace.h).
+
+record   Capture a trace over the serial port: transmitter inputs and the frames built from
+         them, or the channel state the receiver rebuilt from each radio frame (--receiver).
+decode   Print a trace as CSV, one row per record, with the inputs expanded to full state.
+replay   Feed a transmitter trace through the transmitter's pipeline as fast as the link
+         allows. Writes the frames it computed and compares them with the recorded ones.
+
+Traces hold the records exactly as the boards send them.
+
+Requires pyserial for record and replay.
+
+Usage: python tools/trace.py record --port /dev/ttyUSB0 --seconds 10 trace.bin
+       python tools/trace.py record --port /dev/ttyUSB1 --receiver radio.bin
+       python tools/trace.py decode trace.bin
+       python tools/trace.py replay --port /dev/ttyUSB0 trace.bin --out replayed.bin
+"""
+import argparse
+import os
+import struct
+import sys
+import time
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..'))
+from rc_protocol import CHANNEL_VALUES_SIZE, unpack_channel_values  # Generated from RCLink.h
+
+SYNC = 0xA5
+DEFAULT_BAUD = 9600           # Transmitter boot rate
+RECEIVER_BAUD = 115200
+ANALOG_PINS, PORTS, ADC_INPUTS = 8, 3, 4
+PORT_BIT, ADC_BIT, BANK_BIT = 8, 11, 15
+RX_BUFFER_BUDGET = 48         # Bytes in flight, the transmitter's serial buffer holds 64
+
+
+def field_size(bit):
+    return 2 if bit < PORT_BIT or ADC_BIT <= bit < BANK_BIT else 1
+
+
+def record_length(data, offset):
+    """Length of the record at offset, 0 if it is not a record, None if it is incomplete."""
+    if data[offset] != SYNC:
+        return 0
+    if len(data) < offset + 2:
+        return None
+    kind = chr(data[offset + 1])
+    if kind in 'FR':
+        length = 4 + CHANNEL_VALUES_SIZE
+    elif kind == 'E':
+        length = 4
+    elif kind == 'I':
+        if len(data) < offset + 6:
+            return None
+        mask = struct.unpack_from('<H', data, offset + 4)[0]
+        length = 6 + sum(field_size(bit) for bit in range(16) if mask & (1 << bit))
+    else:
+        return 0
+    return length if len(data) >= offset + length else None
+
+
+def take_records(data):
+    """Complete records in a stream and the unparsed tail. Anything between records
+    (command replies) is skipped."""
+    records = []
+    offset = 0
+    while offset < len(data):
+        length = record_length(data, offset)
+        if length is None:
+            break
+        if length == 0:
+            offset += 1
+            continue
+        records.append(bytes(data[offset:offset + length]))
+        offset += length
+    return records, data[offset:]
+
+
+def split_records(data):
+    return take_records(data)[0]
+
+
+def read_trace(path):
+    with open(path, 'rb') as f:
+        return split_records(f.read())
+
+
+def open_transmitter(port, rate):
+    import serial
+
+    link = serial.Serial(port, DEFAULT_BAUD, timeout=1)
+    time.sleep(2)  # Opening the port resets the board
+    link.reset_input_buffer()
+    if rate != DEFAULT_BAUD:
+        # Same negotiation as the config panel: "B<rate>", then the "K" echo test
+        link.write(b'B%d\n' % rate)
+        if link.readline().strip() != b'Y':
+            sys.exit(f'transmitter refused {rate} baud')
+        link.baudrate = rate
+        link.write(b'K42\n')
+        if link.readline().strip() != b'42':
+            sys.exit(f'no echo at {rate} baud')
+    return link
+
+
+def command(link, text):
+    link.write(text.encode() + b'\n')
+    if link.readline().strip() != b'Y':
+        sys.exit(f'"{text}" refused, is the transmitter built with RC_TRACE?')
+
+
+def record(args):
+    import serial
+
+    if args.receiver:
+        link = serial.Serial(args.port, RECEIVER_BAUD, timeout=0.1)
+    else:
+        link = open_transmitter(args.port, args.rate)
+        command(link, 'OR')
+
+    data = bytearray()
+    end = time.monotonic() + args.seconds
+    try:
+        while time.monotonic() < end:
+            data += link.read(4096)
+    except KeyboardInterrupt:
+        pass
+    if not args.receiver:
+        link.write(b'OX\n')
+    link.close()
+
+    records = split_records(data)
+    with open(args.trace, 'wb') as f:
+        f.write(b''.join(records))
+    print(f'{len(records)} records, {len(data)} bytes captured')
+
+
+def decode(args):
+    analog = [0] * ANALOG_PINS
+    ports = [0] * PORTS
+    adc = [0] * ADC_INPUTS
+    bank = 0
+    elapsed = 0
+    print('time_us,type,' + ','.join([f'A{i}' for i in range(ANALOG_PINS)] + ['PIND', 'PINB', 'PINC'] +
+                                     [f'adc{i}' for i in range(ADC_INPUTS)] + ['bank', 'model', 'values']))
+    for rec in read_trace(args.trace):
+        kind = chr(rec[1])
+        elapsed += struct.unpack_from('<H', rec, 2)[0]
+        if kind == 'I':
+            mask = struct.unpack_from('<H', rec, 4)[0]
+            offset = 6
+            for bit in range(16):
+                if not mask & (1 << bit):
+                    continue
+                value = struct.unpack_from('<H' if field_size(bit) == 2 else '<B', rec, offset)[0]
+                offset += field_size(bit)
+                if bit < PORT_BIT:
+                    analog[bit] = value
+                elif bit < ADC_BIT:
+                    ports[bit - PORT_BIT] = value
+                elif bit < BANK_BIT:
+                    adc[bit - ADC_BIT] = value
+                else:
+                    bank = value
+            print(f'{elapsed},I,' + ','.join(str(v) for v in analog + ports + adc + [bank]) + ',,')
+        elif kind in 'FR':
+            model, values = unpack_channel_values(rec[4:])
+            print(f'{elapsed},{kind},' + ',' * (ANALOG_PINS + PORTS + ADC_INPUTS + 1) + f'{model},' + ' '.join(map(str, values)))
+
+
+def replay(args):
+    records = read_trace(args.trace)
+    inputs = [r for r in records if r[1] == ord('I')]
+    recorded = [r[4:] for r in records if r[1] == ord('F')]
+    if not inputs:
+        sys.exit('no input records in the trace')
+    duration = sum(struct.unpack_from('<H', r, 2)[0] for r in records) / 1e6
+
+    link = open_transmitter(args.port, args.rate)
+    command(link, 'OP')
+
+    replayed = []
+    pending = []       # Sizes of the records sent but not answered yet
+    buffer = bytearray()
+    start = time.monotonic()
+    sent = 0
+    while len(replayed) < len(inputs):
+        while sent < len(inputs) and sum(pending) + len(inputs[sent]) <= RX_BUFFER_BUDGET:
+            link.write(inputs[sent])
+            pending.append(len(inputs[sent]))
+            sent += 1
+        chunk = link.read(4 + CHANNEL_VALUES_SIZE)
+        if not chunk:
+            sys.exit(f'no answer after {len(replayed)} frames')
+        buffer += chunk
+        answers, buffer = take_records(buffer)
+        for rec in answers:
+            if rec[1] == ord('F'):
+                replayed.append(rec)
+                pending.pop(0)
+    elapsed = time.monotonic() - start
+
+    link.write(bytes([SYNC, ord('E'), 0, 0]))
+    link.readline()
+    link.close()
+
+    if args.out:
+        with open(args.out, 'wb') as f:
+            f.write(b''.join(replayed))
+
+    print(f'{len(replayed)} frames in {elapsed:.2f} s, {duration / elapsed:.1f}x real time')
+    if recorded:
+        differing = sum(1 for a, b in zip(recorded, replayed) if a != b[4:])
+        print(f'{differing} of {min(len(recorded), len(replayed))} frames differ from the recording')
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    commands = parser.add_subparsers(dest='command', required=True)
+
+    p = commands.add_parser('record', help='capture a trace')
+    p.add_argument('trace')
+    p.add_argument('--port', required=True)
+    p.add_argument('--rate', type=int, default=250000, help='transmitter link rate to negotiate')
+    p.add_argument('--receiver', action='store_true', help='capture the channel state on the receiver')
+    p.add_argument('--seconds', type=float, default=10)
+    p.set_defaults(run=record)
+
+    p = commands.add_parser('decode', help='print a trace as CSV')
+    p.add_argument('trace')
+    p.set_defaults(run=decode)
+
+    p = commands.add_parser('replay', help='replay a transmitter trace')
+    p.add_argument('trace')
+    p.add_argument('--port', required=True)
+    p.add_argument('--rate', type=int, default=250000, help='transmitter link rate to negotiate')
+    p.add_argument('--out', help='write the replayed frames here')
+    p.set_defaults(run=replay)
+
+    args = parser.parse_args()
+    args.run(args)
+
+
+if __name__ == '__main__':
+    main()